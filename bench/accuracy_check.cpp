@@ -0,0 +1,236 @@
+#define _USE_MATH_DEFINES
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <nlohmann/json.hpp>
+
+#include "libcbct.h"
+#include "Reconstruction/pocketfft_hdronly.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Reconstruction variant compared with the reference
+ * @details A variant passes when the PSNR against the reference is at least minPsnr and the max error is at most
+ * maxRelError times the value range of the reference.
+ */
+struct AccuracyVariant {
+    std::string name;
+    double minPsnr;
+    double maxRelError;
+    std::function<VolumeF32(const VolumeF32 &sinogram, const Geometry &geometry)> reconstruct;
+};
+
+/**
+ * @brief FDK of FeldkampCPU computed in double precision
+ * @details The ramp filter, the view angles, the projection of the voxels, the bilinear interpolation and the
+ * accumulation over the views are all in double, with the same conventions as FeldkampCPU, so that the difference
+ * from a variant is its rounding and approximation error alone.
+ */
+static VolumeF32 referenceFDK(const VolumeF32 &sinogram, const Geometry &geom, RampFilter filter) {
+    const int detWidth = geom.detSize.x;
+    const int detHeight = geom.detSize.y;
+    const int nProj = sinogram.size<2>();
+    const uint64_t projSize = (uint64_t)detWidth * detHeight;
+
+    // Ramp filter in the half-complex order of the real FFT, as ProjectionFilter
+    std::vector<double> H(detWidth);
+    for (int x = 0; x < detWidth; x++) {
+        const double q = std::min(x, detWidth - x) / (0.5 * detWidth);
+        H[x] = filter == RampFilter::RamLak ? std::abs(q) : 2.0 / M_PI * std::abs(std::sin(M_PI / 2.0 * q));
+    }
+
+    std::vector<double> filtered(projSize * nProj);
+    OMP_PARALLEL_FOR(int r = 0; r < detHeight * nProj; r++) {
+        pocketfft::detail::pocketfft_r<double> fft(detWidth);
+        double *const row = filtered.data() + (uint64_t)detWidth * r;
+        const float *const src = sinogram.ptr() + (uint64_t)detWidth * r;
+        std::copy(src, src + detWidth, row);
+        fft.exec(row, 1.0, true);
+        for (int x = 0; x < detWidth; x++) {
+            row[x] *= H[(x + 1) / 2];
+        }
+        fft.exec(row, 1.0 / detWidth, false);
+    }
+
+    const vec3i volSize = geom.volSize;
+    const double vs = voxelSize(geom);
+    VolumeF32 volume(volSize.x, volSize.y, volSize.z);
+    float *const out = volume.ptr();
+    OMP_PARALLEL_FOR(int r = 0; r < volSize.y * volSize.z; r++) {
+        const int y = r % volSize.y;
+        const int z = r / volSize.y;
+        const double wy = (y - volSize.y * 0.5) * vs;
+        const double wz = (z - volSize.z * 0.5) * vs;
+        for (int x = 0; x < volSize.x; x++) {
+            const double wx = (x - volSize.x * 0.5) * vs;
+            double sum = 0.0;
+            for (int i = 0; i < nProj; i++) {
+                const double theta = 2.0 * M_PI * i / nProj;
+                const double c = std::cos(theta), s = std::sin(theta);
+                const double vx = wx * c - wy * s + geom.sod;
+                const double vy = wx * s + wy * c;
+                const double u = vy * geom.sdd / std::abs(vx);
+                const double v = wz * geom.sdd / std::abs(vx);
+                const double w = geom.sdd / std::sqrt(geom.sdd * geom.sdd + u * u + v * v);
+                const double px = u / geom.pixSize.x + detWidth * 0.5;
+                const double py = v / geom.pixSize.y + detHeight * 0.5;
+                if (px < 0.0 || py < 0.0 || px >= detWidth || py >= detHeight) {
+                    continue;
+                }
+
+                // Same clamping at the borders as bilerp()
+                const double fx = px - 0.5, fy = py - 0.5;
+                const int x0 = std::clamp((int)std::floor(fx), 0, detWidth - 2);
+                const int y0 = std::clamp((int)std::floor(fy), 0, detHeight - 2);
+                const double a = fx - x0, b = fy - y0;
+                const double *const p = filtered.data() + projSize * i + (uint64_t)y0 * detWidth + x0;
+                const double v0 = p[0] + a * (p[1] - p[0]);
+                const double v1 = p[detWidth] + a * (p[detWidth + 1] - p[detWidth]);
+                sum += (v0 + b * (v1 - v0)) * w;
+            }
+            out[((uint64_t)z * volSize.y + y) * volSize.x + x] = (float)(sum / nProj);
+        }
+    }
+    return volume;
+}
+
+//! Raw counts whose log transform in FeldkampCPU gives back the sinogram, up to the 16-bit quantization
+static VolumeU16 toCounts(const VolumeF32 &sinogram, float freeRay) {
+    VolumeU16 counts(sinogram.size<0>(), sinogram.size<1>(), sinogram.size<2>());
+    for (uint64_t i = 0; i < sinogram.count(); i++) {
+        const double c = std::round(freeRay * std::exp(-(double)sinogram.ptr()[i]) - 1.0);
+        counts.ptr()[i] = (uint16_t)std::clamp(c, 0.0, 65535.0);
+    }
+    return counts;
+}
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("cbct_accuracy", "Accuracy of the reconstruction variants against a double-precision FDK");
+    options.add_options()("h,help", "Print help");
+    options.add_options()("det", "Detector size (square)", cxxopts::value<int>()->default_value("128"));
+    options.add_options()("views", "Number of views", cxxopts::value<int>()->default_value("120"));
+    options.add_options()("vol", "Volume size (cubic)", cxxopts::value<int>()->default_value("64"));
+    options.add_options()("thresholds", "JSON file overriding the thresholds of the variants",
+                          cxxopts::value<std::string>());
+    options.add_options()("o,output", "Output file", cxxopts::value<std::string>()->default_value("accuracy.json"));
+    const auto configs = options.parse(argc, argv);
+
+    if (configs["help"].count() != 0) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const int det = configs["det"].as<int>();
+    const int vol = configs["vol"].as<int>();
+    const int nViews = configs["views"].as<int>();
+    const Geometry geometry(vec2i(det, det), vec2f(0.2f, 0.2f), vec3i(vol), 500.0f, 1000.0f);
+    const RampFilter filter = RampFilter::SheppLogan;
+    const float freeRay = 60000.0f;
+
+    const ReconstructionControl control = ReconstructionControl::silent();
+
+    // Every variant of the reconstruction is registered here with its thresholds
+    std::vector<AccuracyVariant> variants;
+    variants.push_back({ "session", 100.0, 1.0e-4, [&](const VolumeF32 &s, const Geometry &g) {
+                            return FeldkampCPU(filter).reconstruct(s, g, control);
+                        } });
+    variants.push_back({ "split", 100.0, 1.0e-4, [&](const VolumeF32 &s, const Geometry &g) {
+                            FeldkampCPU fdk(filter);
+                            return fdk.backproject(fdk.filterProjections(s, control), g, control);
+                        } });
+    variants.push_back({ "slab", 100.0, 1.0e-4, [&](const VolumeF32 &s, const Geometry &g) {
+                            FeldkampCPU fdk(filter);
+                            fdk.setSlabHeight(std::max(1, g.volSize.z / 3));
+                            return fdk.reconstruct(s, g, control);
+                        } });
+    variants.push_back({ "brick16", 100.0, 1.0e-4, [&](const VolumeF32 &s, const Geometry &g) {
+                            return FeldkampCPU(filter, 16).reconstruct(s, g, control);
+                        } });
+    variants.push_back({ "batch4", 100.0, 1.0e-4, [&](const VolumeF32 &s, const Geometry &g) {
+                            TuningConfig tuning;
+                            tuning.viewBatch = 4;
+                            FeldkampCPU fdk(filter);
+                            fdk.setTuning(tuning);
+                            return fdk.reconstruct(s, g, control);
+                        } });
+    variants.push_back({ "counts-u16", 50.0, 1.0e-2, [&](const VolumeF32 &s, const Geometry &g) {
+                            return FeldkampCPU(filter).reconstruct(toCounts(s, freeRay), freeRay, g, control);
+                        } });
+#if defined(LIBCBCT_WITH_CUDA)
+    variants.push_back({ "cuda", 80.0, 1.0e-3, [&](const VolumeF32 &s, const Geometry &g) {
+                            return FeldkampCUDA(filter).reconstruct(s, g, control);
+                        } });
+#endif
+
+    if (configs["thresholds"].count() != 0) {
+        const std::string path = configs["thresholds"].as<std::string>();
+        std::ifstream reader(path.c_str(), std::ios::in);
+        if (reader.fail()) {
+            LIBCBCT_ERROR("Failed to open file: %s", path.c_str());
+        }
+        const json thresholds = json::parse(reader);
+        for (AccuracyVariant &v : variants) {
+            if (thresholds.contains(v.name)) {
+                v.minPsnr = thresholds[v.name].value("minPsnr", v.minPsnr);
+                v.maxRelError = thresholds[v.name].value("maxRelError", v.maxRelError);
+            }
+        }
+    }
+
+    const std::pair<const char *, Phantom> phantoms[] = {
+        { "shepp-logan", Phantom::sheppLogan() },
+        { "cuboids", Phantom::cuboidInserts() },
+    };
+
+    json results = json::array();
+    int failures = 0;
+    std::printf("%-12s %-12s %12s %12s %10s  %s\n", "Phantom", "Variant", "Max error", "RMS error", "PSNR [dB]",
+                "Result");
+    for (const auto &[phantomName, phantom] : phantoms) {
+        const VolumeF32 sinogram = phantom.project(geometry, nViews);
+        const VolumeF32 reference = referenceFDK(sinogram, geometry, filter);
+        const auto [refMin, refMax] = reference.getMinMax();
+        const double range = (double)refMax - (double)refMin;
+
+        for (const AccuracyVariant &v : variants) {
+            const VolumeF32 volume = v.reconstruct(sinogram, geometry);
+            const VolumeError error = VolumeError::compute(volume.ptr(), reference.ptr(), reference.count());
+            const bool pass = error.psnr >= v.minPsnr && error.maxAbs <= v.maxRelError * range;
+            failures += pass ? 0 : 1;
+
+            std::printf("%-12s %-12s %12.4e %12.4e %10.2f  %s\n", phantomName, v.name.c_str(), error.maxAbs, error.rms,
+                        error.psnr, pass ? "PASS" : "FAIL");
+            results.push_back({ { "phantom", phantomName },
+                                { "variant", v.name },
+                                { "maxError", error.maxAbs },
+                                { "rmsError", error.rms },
+                                { "psnr", error.psnr },
+                                { "pass", pass } });
+        }
+    }
+
+    const std::string outputPath = configs["output"].as<std::string>();
+    std::ofstream writer(outputPath.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", outputPath.c_str());
+    }
+    writer << json({ { "geometry", { { "detSize", det }, { "views", nViews }, { "volSize", vol } } },
+                     { "results", results } })
+                  .dump(2)
+           << std::endl;
+
+    if (failures != 0) {
+        LIBCBCT_WARN("%d variant(s) exceed the error thresholds", failures);
+        return 1;
+    }
+    LIBCBCT_INFO("All the variants are within the error thresholds");
+    return 0;
+}
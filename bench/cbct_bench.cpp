@@ -0,0 +1,212 @@
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <nlohmann/json.hpp>
+
+#include "libcbct.h"
+
+using json = nlohmann::json;
+
+struct BenchResult {
+    int detSize;
+    int nViews;
+    int volSize;
+    int threads;
+    double reconSec;
+    double gvus;
+    double filterSec;
+    double filterMpixPerSec;
+    double peakRssMiB;
+    double rmsError;
+    double psnr;
+};
+
+static std::vector<int> parseList(const std::string &text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(std::stoi(item));
+        }
+    }
+    if (values.empty()) {
+        LIBCBCT_ERROR("Empty list of values: %s", text.c_str());
+    }
+    return values;
+}
+
+static void writeJson(const std::string &filename, const std::vector<BenchResult> &results) {
+    json root;
+    root["benchmark"] = "cbct_bench";
+    root["maxThreads"] = omp_get_max_threads();
+    root["results"] = json::array();
+    for (const BenchResult &r : results) {
+        root["results"].push_back({
+            { "detSize", r.detSize },
+            { "views", r.nViews },
+            { "volSize", r.volSize },
+            { "threads", r.threads },
+            { "reconSec", r.reconSec },
+            { "gvus", r.gvus },
+            { "filterSec", r.filterSec },
+            { "filterMpixPerSec", r.filterMpixPerSec },
+            { "peakRssMiB", r.peakRssMiB },
+            { "rmsError", r.rmsError },
+            { "psnr", r.psnr },
+        });
+    }
+
+    std::ofstream writer(filename.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    writer << root.dump(2) << std::endl;
+}
+
+static void writeCsv(const std::string &filename, const std::vector<BenchResult> &results) {
+    std::ofstream writer(filename.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    writer << "detSize,views,volSize,threads,reconSec,gvus,filterSec,filterMpixPerSec,peakRssMiB,rmsError,psnr\n";
+    for (const BenchResult &r : results) {
+        writer << r.detSize << "," << r.nViews << "," << r.volSize << "," << r.threads << "," << r.reconSec << ","
+               << r.gvus << "," << r.filterSec << "," << r.filterMpixPerSec << "," << r.peakRssMiB << ","
+               << r.rmsError << "," << r.psnr << "\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("cbct_bench", "Reconstruction benchmark with analytic phantom projections");
+    options.add_options()("h,help", "Print help");
+    options.add_options()("det", "Detector sizes (square, comma separated)",
+                          cxxopts::value<std::string>()->default_value("256,512"));
+    options.add_options()("views", "Numbers of views (comma separated)",
+                          cxxopts::value<std::string>()->default_value("180,360"));
+    options.add_options()("vol", "Volume sizes (cubic, comma separated)",
+                          cxxopts::value<std::string>()->default_value("128,256"));
+    options.add_options()("threads", "Thread counts (comma separated, 0 for all the threads)",
+                          cxxopts::value<std::string>()->default_value("0"));
+    options.add_options()("phantom", "Phantom (shepp-logan or cuboids)",
+                          cxxopts::value<std::string>()->default_value("shepp-logan"));
+    options.add_options()("r,repeat", "Runs of each case, of which the fastest is reported",
+                          cxxopts::value<int>()->default_value("3"));
+    options.add_options()("f,format", "Output format (json or csv)",
+                          cxxopts::value<std::string>()->default_value("json"));
+    options.add_options()("o,output", "Output file", cxxopts::value<std::string>()->default_value("cbct_bench.json"));
+    const auto configs = options.parse(argc, argv);
+
+    if (configs["help"].count() != 0) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const std::vector<int> detSizes = parseList(configs["det"].as<std::string>());
+    const std::vector<int> viewCounts = parseList(configs["views"].as<std::string>());
+    const std::vector<int> volSizes = parseList(configs["vol"].as<std::string>());
+    const std::vector<int> threadCounts = parseList(configs["threads"].as<std::string>());
+    const int repeat = std::max(1, configs["repeat"].as<int>());
+    const std::string format = configs["format"].as<std::string>();
+    if (format != "json" && format != "csv") {
+        LIBCBCT_ERROR("Unknown output format: %s", format.c_str());
+    }
+
+    const int maxThreads = omp_get_max_threads();
+    LIBCBCT_INFO("OpenMP threads: %d", maxThreads);
+
+    // The progress of the timed runs is not printed
+    const ReconstructionControl control = ReconstructionControl::silent();
+
+    const std::string phantomName = configs["phantom"].as<std::string>();
+    Phantom phantom;
+    if (phantomName == "shepp-logan") {
+        phantom = Phantom::sheppLogan();
+    } else if (phantomName == "cuboids") {
+        phantom = Phantom::cuboidInserts();
+    } else {
+        LIBCBCT_ERROR("Unknown phantom: %s", phantomName.c_str());
+    }
+
+    std::vector<BenchResult> results;
+    std::printf("%8s %8s %8s %8s %12s %10s %12s %14s %12s %10s\n", "Detector", "Views", "Volume", "Threads",
+                "Recon [s]", "GVU/s", "Filter [s]", "Filter [Mpx/s]", "Peak [MiB]", "PSNR [dB]");
+    for (int det : detSizes) {
+        // The ground truth of each volume size is shared by the view counts
+        std::map<int, VolumeF32> truths;
+
+        for (int nViews : viewCounts) {
+            // The extent of the volume depends only on the detector, so that the projections are shared by the
+            // volume sizes
+            Geometry geometry(vec2i(det, det), vec2f(0.2f, 0.2f), vec3i(volSizes[0]), 500.0f, 1000.0f);
+            const VolumeF32 sinogram = phantom.project(geometry, nViews);
+
+            for (int vol : volSizes) {
+                geometry.volSize = vec3i(vol, vol, vol);
+                if (truths.count(vol) == 0) {
+                    truths[vol] = phantom.voxelize(geometry);
+                }
+                const VolumeF32 &truth = truths[vol];
+
+                for (int threads : threadCounts) {
+                    threads = threads > 0 ? threads : maxThreads;
+                    omp_set_num_threads(threads);
+
+                    // The high-water mark is reset to the current resident memory, so that the peak is that of this
+                    // case (where the reset is not supported, it stays the peak of the process so far)
+                    MemoryTracker::resetResidentPeak();
+
+                    // Defaults rather than the tuning of the host, with all the threads of the case in both stages,
+                    // so that the results compare the same code paths across hosts and thread counts
+                    TuningConfig tuning;
+                    tuning.filterThreads = threads;
+                    tuning.backprojectThreads = threads;
+                    FeldkampCPU fdk(RampFilter::SheppLogan, tuning.brickSize);
+                    fdk.setTuning(tuning);
+
+                    // The session and its buffers are created by the first (untimed) run, whose result is compared
+                    // with the ground truth after fitting the gain of the reconstruction
+                    const VolumeF32 tomogram = fdk.reconstruct(sinogram, geometry, control);
+                    const VolumeError error = VolumeError::compute(tomogram.ptr(), truth.ptr(), truth.count(), true);
+
+                    BenchResult result;
+                    result.detSize = det;
+                    result.nViews = nViews;
+                    result.volSize = vol;
+                    result.threads = threads;
+                    result.reconSec = bestOf(repeat, [&] { fdk.reconstruct(sinogram, geometry, control); });
+                    result.filterSec = bestOf(repeat, [&] { fdk.filterProjections(sinogram, control); });
+                    result.gvus = (double)vol * vol * vol * nViews / result.reconSec * 1.0e-9;
+                    result.filterMpixPerSec = (double)det * det * nViews / result.filterSec * 1.0e-6;
+                    result.peakRssMiB = MemoryPlanner::peakResidentMemory() / (1024.0 * 1024.0);
+                    result.rmsError = error.rms;
+                    result.psnr = error.psnr;
+                    results.push_back(result);
+
+                    std::printf("%8d %8d %8d %8d %12.3f %10.3f %12.3f %14.1f %12.1f %10.2f\n", det, nViews, vol,
+                                threads, result.reconSec, result.gvus, result.filterSec, result.filterMpixPerSec,
+                                result.peakRssMiB, result.psnr);
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+    omp_set_num_threads(maxThreads);
+
+    const std::string outputPath = configs["output"].as<std::string>();
+    if (format == "json") {
+        writeJson(outputPath, results);
+    } else {
+        writeCsv(outputPath, results);
+    }
+    LIBCBCT_INFO("Results saved: %s", outputPath.c_str());
+
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include <cstdio>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <nlohmann/json.hpp>
+
+#include "libcbct.h"
+#include "Utils/ImageUtils.h"
+
+using json = nlohmann::json;
+
+struct MicroResult {
+    std::string kernel;
+    std::string size;
+    bool cold;
+    double nsPerOp;
+    double bytesPerOp;
+};
+
+/**
+ * @brief Timer of the kernels, each of which runs a fixed number of operations per call
+ * @details A kernel is called once untimed, and then "repeat" times, of which the median time is reported. For the
+ * cold-cache measurement, a buffer larger than the last-level cache is streamed through before each call, so that
+ * the data of the kernel are evicted.
+ */
+class MicroBench {
+public:
+    MicroBench(int repeat, uint64_t flushBytes, const std::string &filter)
+        : repeat{ repeat }
+        , flushBuffer(flushBytes / sizeof(float), 1.0f)
+        , filter{ filter } {
+    }
+
+    void run(const std::string &kernel, const std::string &size, uint64_t ops, double bytesPerOp,
+             const std::function<void()> &func) {
+        if (!filter.empty() && kernel.find(filter) == std::string::npos) {
+            return;
+        }
+
+        for (bool cold : { false, true }) {
+            func();
+            std::vector<double> times;
+            for (int r = 0; r < repeat; r++) {
+                if (cold) {
+                    flushCaches();
+                }
+                const auto start = std::chrono::steady_clock::now();
+                func();
+                const auto end = std::chrono::steady_clock::now();
+                times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+            }
+            std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+            const double nsPerOp = times[times.size() / 2] / (double)ops;
+
+            results.push_back({ kernel, size, cold, nsPerOp, bytesPerOp });
+            std::printf("%-14s %-12s %-5s %12.3f %10.1f %10.2f\n", kernel.c_str(), size.c_str(),
+                        cold ? "cold" : "warm", nsPerOp, bytesPerOp, bytesPerOp / nsPerOp);
+            std::fflush(stdout);
+        }
+    }
+
+    const std::vector<MicroResult> &getResults() const {
+        return results;
+    }
+
+private:
+    void flushCaches() {
+        float sum = 0.0f;
+        for (float &v : flushBuffer) {
+            v += 1.0f;
+            sum += v;
+        }
+        sink = sum;
+    }
+
+    int repeat;
+    std::vector<float> flushBuffer;
+    std::string filter;
+    std::vector<MicroResult> results;
+    volatile float sink = 0.0f;
+};
+
+static std::string sizeText(int x, int y, int z = 1) {
+    return z > 1 ? STR_FMT("%dx%dx%d", x, y, z) : STR_FMT("%dx%d", x, y);
+}
+
+static void writeJson(const std::string &filename, const std::vector<MicroResult> &results, int threads) {
+    json root;
+    root["benchmark"] = "cbct_microbench";
+    root["threads"] = threads;
+    root["results"] = json::array();
+    for (const MicroResult &r : results) {
+        root["results"].push_back({
+            { "kernel", r.kernel },
+            { "size", r.size },
+            { "cache", r.cold ? "cold" : "warm" },
+            { "nsPerOp", r.nsPerOp },
+            { "bytesPerOp", r.bytesPerOp },
+        });
+    }
+
+    std::ofstream writer(filename.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    writer << root.dump(2) << std::endl;
+}
+
+//! Print the speedup of each case over the same case in a previous output (above 1 is faster)
+static void compareBaseline(const std::string &filename, const std::vector<MicroResult> &results) {
+    std::ifstream reader(filename.c_str(), std::ios::in);
+    if (reader.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    const json baseline = json::parse(reader);
+
+    std::printf("\n%-14s %-12s %-5s %12s %12s %8s\n", "Kernel", "Size", "Cache", "Base [ns]", "Now [ns]", "Speedup");
+    for (const MicroResult &r : results) {
+        for (const auto &b : baseline["results"]) {
+            if (b["kernel"] == r.kernel && b["size"] == r.size && b["cache"] == (r.cold ? "cold" : "warm")) {
+                const double base = b["nsPerOp"].get<double>();
+                std::printf("%-14s %-12s %-5s %12.3f %12.3f %8.2f\n", r.kernel.c_str(), r.size.c_str(),
+                            r.cold ? "cold" : "warm", base, r.nsPerOp, base / r.nsPerOp);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("cbct_microbench", "Micro-benchmarks of the reconstruction primitives");
+    options.add_options()("h,help", "Print help");
+    options.add_options()("k,kernel", "Run only the kernels whose name contains this text",
+                          cxxopts::value<std::string>()->default_value(""));
+    options.add_options()("r,repeat", "Timed calls of each kernel, of which the median is reported",
+                          cxxopts::value<int>()->default_value("11"));
+    options.add_options()("threads", "Number of threads of the parallel kernels",
+                          cxxopts::value<int>()->default_value("1"));
+    options.add_options()("flush", "Size in MiB of the buffer evicting the caches before the cold calls",
+                          cxxopts::value<int>()->default_value("128"));
+    options.add_options()("baseline", "Previous output to compare with", cxxopts::value<std::string>());
+    options.add_options()("o,output", "Output file", cxxopts::value<std::string>()->default_value("micro.json"));
+    const auto configs = options.parse(argc, argv);
+
+    if (configs["help"].count() != 0) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const int threads = std::max(1, configs["threads"].as<int>());
+    omp_set_num_threads(threads);
+    MicroBench bench(std::max(1, configs["repeat"].as<int>()), (uint64_t)configs["flush"].as<int>() << 20,
+                     configs["kernel"].as<std::string>());
+    std::mt19937 rng(31415);
+    volatile float sink = 0.0f;
+
+    std::printf("%-14s %-12s %-5s %12s %10s %10s\n", "Kernel", "Size", "Cache", "ns/op", "bytes/op", "GB/s");
+
+    // Bilinear sampling at random positions (4 floats read per sample), as the backprojection does
+    for (int size : { 256, 1024, 4096 }) {
+        std::vector<float> image((uint64_t)size * size);
+        std::uniform_real_distribution<float> value(0.0f, 1.0f), coord(0.0f, (float)size);
+        std::generate(image.begin(), image.end(), [&] { return value(rng); });
+        std::vector<vec2f> points(1 << 20);
+        std::generate(points.begin(), points.end(), [&] { return vec2f(coord(rng), coord(rng)); });
+
+        bench.run("bilerp", sizeText(size, size), points.size(), 4.0 * sizeof(float), [&] {
+            float sum = 0.0f;
+            for (const vec2f &p : points) {
+                sum += bilerp(image.data(), size, size, p.x - 0.5f, p.y - 0.5f);
+            }
+            sink = sum;
+        });
+    }
+
+    // Voxel-to-detector projection of a row of voxels, with the angle (vox2pix) or its cosine and sine (project)
+    for (int size : { 256, 1024 }) {
+        const Geometry geometry(vec2i(size, size), vec2f(0.2f, 0.2f), vec3i(size, size, size), 500.0f, 1000.0f);
+        const float theta = 0.3f;
+        const float cosT = cosf(theta), sinT = sinf(theta);
+        const uint64_t ops = (uint64_t)size * 64;
+
+        bench.run("vox2pix", sizeText(size, 64), ops, 0.0, [&] {
+            float sum = 0.0f;
+            for (int y = 0; y < 64; y++) {
+                for (int x = 0; x < size; x++) {
+                    sum += vox2pix(vec3i(x, y + size / 2, size / 2), theta, geometry).x;
+                }
+            }
+            sink = sum;
+        });
+
+        const float vs = voxelSize(geometry);
+        bench.run("project", sizeText(size, 64), ops, 0.0, [&] {
+            float sum = 0.0f;
+            for (int y = 0; y < 64; y++) {
+                const float wy = y * vs;
+                for (int x = 0; x < size; x++) {
+                    sum += project(vec3f((x - size * 0.5f) * vs, wy, 0.0f), cosT, sinT, geometry).x;
+                }
+            }
+            sink = sum;
+        });
+    }
+
+    // Ramp filtering of a projection in place (one float read and written per pixel)
+    for (int size : { 256, 512, 1024, 2048 }) {
+        ProjectionFilter projFilter(RampFilter::SheppLogan, size, size);
+        std::vector<float> proj((uint64_t)size * size);
+        std::uniform_real_distribution<float> value(0.0f, 1.0f);
+        std::generate(proj.begin(), proj.end(), [&] { return value(rng); });
+
+        bench.run("ramp filter", sizeText(size, size), proj.size(), 2.0 * sizeof(float),
+                  [&] { projFilter.apply(proj.data()); });
+    }
+
+    // Volume reductions and voxel-wise updates
+    for (int size : { 64, 128, 256 }) {
+        VolumeF32 volume(size, size, size);
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+        std::generate(volume.ptr(), volume.ptr() + volume.count(), [&] { return value(rng); });
+
+        bench.run("getMinMax", sizeText(size, size, size), volume.count(), sizeof(float), [&] {
+            volume.markModified();
+            sink = std::get<1>(volume.getMinMax());
+        });
+
+        bench.run("forEach", sizeText(size, size, size), volume.count(), 2.0 * sizeof(float),
+                  [&] { volume.forEach([](float v) { return v * 0.5f + 0.25f; }); });
+    }
+
+    const std::string outputPath = configs["output"].as<std::string>();
+    writeJson(outputPath, bench.getResults(), threads);
+    LIBCBCT_INFO("Results saved: %s", outputPath.c_str());
+
+    if (configs["baseline"].count() != 0) {
+        compareBaseline(configs["baseline"].as<std::string>(), bench.getResults());
+    }
+
+    return 0;
+}
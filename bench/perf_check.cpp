@@ -0,0 +1,242 @@
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+#include <nlohmann/json.hpp>
+
+#include "libcbct.h"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+#if !defined(LIBCBCT_PERF_BASELINE)
+#define LIBCBCT_PERF_BASELINE "perf_baseline.json"
+#endif
+
+#if !defined(LIBCBCT_BUILD_TYPE)
+#define LIBCBCT_BUILD_TYPE "unknown"
+#endif
+
+//! Exit status of a check without baselines for this host, which ctest reports as skipped (SKIP_RETURN_CODE)
+static const int kSkipReturnCode = 77;
+
+//! Fixed reconstruction measured by the check, with a pinned number of threads
+struct PerfCase {
+    const char *name;
+    int detSize;
+    int nViews;
+    int volSize;
+    int threads;
+};
+
+/**
+ * @brief Measured values of a case, with the direction in which each one improves
+ * @details Host-independent metrics of the cases with pinned thread counts are kept in the baseline file of the
+ * repository, and all the others, e.g., the timings, in the baseline file of the host.
+ */
+struct PerfMetric {
+    const char *name;
+    bool higherIsBetter;
+    bool hostIndependent;
+};
+
+static const PerfCase kCases[] = {
+    { "small-1t", 128, 120, 64, 1 },
+    { "medium-1t", 192, 120, 96, 1 },
+    { "medium-mt", 192, 120, 96, 0 },  // Zero for all the threads of the host
+};
+
+static const PerfMetric kMetrics[] = {
+    { "gvus", true, false },
+    { "filterMs", false, false },
+    { "backprojectMs", false, false },
+    { "peakMiB", false, true },
+};
+
+static json measure(const PerfCase &c, int repeat) {
+    const int threads = c.threads > 0 ? c.threads : omp_get_max_threads();
+    omp_set_num_threads(threads);
+
+    const Geometry geometry(vec2i(c.detSize, c.detSize), vec2f(0.2f, 0.2f), vec3i(c.volSize), 500.0f, 1000.0f);
+    const VolumeF32 sinogram = Phantom::sheppLogan().project(geometry, c.nViews);
+
+    const ReconstructionControl control = ReconstructionControl::silent();
+    // Defaults rather than the tuning of the host, so that the baselines compare the same code paths
+    FeldkampCPU fdk(RampFilter::SheppLogan, TuningConfig().brickSize);
+    fdk.reconstruct(sinogram, geometry, control);
+
+    const double reconSec = bestOf(repeat, [&] { fdk.reconstruct(sinogram, geometry, control); });
+    VolumeF32 filtered;
+    const double filterSec = bestOf(repeat, [&] { filtered = fdk.filterProjections(sinogram, control); });
+    const double backprojectSec = bestOf(repeat, [&] { fdk.backproject(filtered, geometry, control); });
+
+    // Allocations are tracked in a separate run, since the stages reset the resident high-water mark. The tracked
+    // peak is deterministic for a thread count, and the stages are also checked against the memory plan.
+    filtered = VolumeF32();
+    MemoryTracker::enable();
+    MemoryTracker::clear();
+    MemoryTracker::resetPeak();
+    fdk.reconstruct(sinogram, geometry, control);
+    MemoryTracker::enable(false);
+    const double peakMiB = MemoryTracker::peak() / (1024.0 * 1024.0);
+    const MemoryPlanner planner(geometry.detSize, c.nViews, geometry.volSize);
+    const bool withinPlan = planner.evaluate(VolumeType::Float32, 0, false, 0, 0).verify(MemoryTracker::stages());
+
+    const double updates = (double)c.volSize * c.volSize * c.volSize * c.nViews;
+    return { { "threads", threads },
+             { "gvus", updates / reconSec * 1.0e-9 },
+             { "filterMs", filterSec * 1.0e3 },
+             { "backprojectMs", backprojectSec * 1.0e3 },
+             { "peakMiB", peakMiB },
+             { "withinPlan", withinPlan } };
+}
+
+//! Baselines of this host and build, next to its tuning file (see AutoTuner)
+static std::string hostBaselinePath() {
+    return (fs::path(HostCalibration::cacheDirectory()) / ("perf-" + HostCalibration::hostName() + ".json")).string();
+}
+
+static json readBaseline(const std::string &path, double tolerance) {
+    json baseline = json::object();
+    std::ifstream reader(path.c_str(), std::ios::in);
+    if (!reader.fail()) {
+        baseline = json::parse(reader);
+    }
+    if (!baseline.contains("tolerance")) {
+        baseline["tolerance"] = tolerance;
+    }
+    if (!baseline.contains("cases")) {
+        baseline["cases"] = json::object();
+    }
+    return baseline;
+}
+
+static void writeBaseline(const std::string &path, const json &baseline) {
+    std::ofstream writer(path.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", path.c_str());
+    }
+    writer << baseline.dump(2) << std::endl;
+    LIBCBCT_INFO("Baselines saved: %s", path.c_str());
+}
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("cbct_perfcheck", "Performance regression check against stored baselines");
+    options.add_options()("h,help", "Print help");
+    options.add_options()("b,baseline", "Baseline file of the host-independent metrics",
+                          cxxopts::value<std::string>()->default_value(LIBCBCT_PERF_BASELINE));
+    options.add_options()("host-baseline", "Baseline file of this host (default: perf-<host>.json in the cache)",
+                          cxxopts::value<std::string>());
+    options.add_options()("bless", "Overwrite the baselines with the measured values");
+    options.add_options()("tolerance", "Relative tolerance used when the baseline file does not give one",
+                          cxxopts::value<double>()->default_value("0.2"));
+    options.add_options()("r,repeat", "Runs of each case, of which the fastest is compared",
+                          cxxopts::value<int>()->default_value("3"));
+    const auto configs = options.parse(argc, argv);
+
+    if (configs["help"].count() != 0) {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    const std::string baselinePath = configs["baseline"].as<std::string>();
+    const std::string hostPath =
+        configs["host-baseline"].count() != 0 ? configs["host-baseline"].as<std::string>() : hostBaselinePath();
+    const bool bless = configs["bless"].count() != 0;
+    const int repeat = std::max(1, configs["repeat"].as<int>());
+
+    json shared = readBaseline(baselinePath, configs["tolerance"].as<double>());
+    json host = readBaseline(hostPath, configs["tolerance"].as<double>());
+
+    // Timings of another build type, e.g., a debug build, are not comparable
+    const std::string buildType = host.value("buildType", "");
+    if (!host["cases"].empty() && buildType != LIBCBCT_BUILD_TYPE) {
+        LIBCBCT_WARN("Baselines of this host were measured with a %s build, not %s", buildType.c_str(),
+                     LIBCBCT_BUILD_TYPE);
+        host["cases"] = json::object();
+    }
+    host["host"] = HostCalibration::hostName();
+    host["buildType"] = LIBCBCT_BUILD_TYPE;
+
+    const int maxThreads = omp_get_max_threads();
+    int failures = 0;
+    int hostCompared = 0;
+    std::printf("%-12s %-14s %12s %12s %8s  %s\n", "Case", "Metric", "Baseline", "Measured", "Change", "Result");
+    for (const PerfCase &c : kCases) {
+        const int threads = c.threads > 0 ? c.threads : maxThreads;
+        const auto baselineOf = [&](const PerfMetric &m) -> json & {
+            return m.hostIndependent && c.threads > 0 ? shared : host;
+        };
+
+        // Values measured with another thread count are not comparable
+        const auto comparable = [&](const PerfMetric &m) {
+            const json &stored = baselineOf(m)["cases"].value(c.name, json::object());
+            return stored.contains(m.name) && stored.value("threads", 0) == threads;
+        };
+        if (!bless && std::none_of(std::begin(kMetrics), std::end(kMetrics), comparable)) {
+            std::printf("%-12s %-14s %12s %12s %8s  %s\n", c.name, "-", "-", "-", "-", "SKIPPED");
+            LIBCBCT_WARN("Case %s has no baseline for %d threads", c.name, threads);
+            continue;
+        }
+        const json measured = measure(c, repeat);
+
+        if (!measured["withinPlan"].get<bool>()) {
+            LIBCBCT_WARN("Case %s exceeds the memory plan", c.name);
+            failures++;
+        }
+
+        for (const PerfMetric &m : kMetrics) {
+            json &baseline = baselineOf(m);
+            json &stored = baseline["cases"][c.name];
+            const double value = measured[m.name].get<double>();
+            if (bless) {
+                stored["threads"] = threads;
+                stored[m.name] = value;
+                std::printf("%-12s %-14s %12s %12.3f %8s  %s\n", c.name, m.name, "-", value, "-", "BLESSED");
+                continue;
+            }
+            if (!comparable(m)) {
+                std::printf("%-12s %-14s %12s %12.3f %8s  %s\n", c.name, m.name, "-", value, "-", "NO BASELINE");
+                continue;
+            }
+
+            // Per-metric tolerances of a case override the global one of its file
+            double tolerance = baseline["tolerance"].get<double>();
+            if (stored.contains("tolerance") && stored["tolerance"].contains(m.name)) {
+                tolerance = stored["tolerance"][m.name].get<double>();
+            }
+
+            const double base = stored[m.name].get<double>();
+            const double change = value / base - 1.0;
+            const bool pass = m.higherIsBetter ? change >= -tolerance : change <= tolerance;
+            failures += pass ? 0 : 1;
+            hostCompared += &baseline == &host ? 1 : 0;
+            std::printf("%-12s %-14s %12.3f %12.3f %+7.1f%%  %s\n", c.name, m.name, base, value, 100.0 * change,
+                        pass ? "PASS" : "FAIL");
+        }
+    }
+    omp_set_num_threads(maxThreads);
+
+    if (bless) {
+        writeBaseline(baselinePath, shared);
+        writeBaseline(hostPath, host);
+        return 0;
+    }
+
+    if (failures != 0) {
+        LIBCBCT_WARN("%d metric(s) regressed beyond the tolerance", failures);
+        return 1;
+    }
+    // The timings depend on the host, so that a host without baselines skips the check rather than passing it
+    if (hostCompared == 0) {
+        LIBCBCT_WARN("No baselines of this host in %s (run with --bless on this host)", hostPath.c_str());
+        return kSkipReturnCode;
+    }
+    LIBCBCT_INFO("All the metrics are within the tolerance");
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_HASH_H
+#define LIBCBCT_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief Incremental 64-bit FNV-1a hash used to key cached intermediate results
+ * @details Values are hashed by their bytes, so that the key is stable only across runs on the same platform.
+ */
+class Hasher {
+public:
+    void addBytes(const void *data, uint64_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (uint64_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * kPrime;
+        }
+    }
+
+    void add(const std::string &str) {
+        // The length is hashed as well, so that consecutive strings cannot be confused
+        add((uint64_t)str.size());
+        addBytes(str.data(), str.size());
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T>>>
+    void add(const T &value) {
+        addBytes(&value, sizeof(T));
+    }
+
+    template <typename T, typename U, typename... Args>
+    void add(const T &value, const U &next, const Args &...args) {
+        add(value);
+        add(next, args...);
+    }
+
+    uint64_t value() const {
+        return hash;
+    }
+
+private:
+    static constexpr uint64_t kOffset = 14695981039346656037ull;
+    static constexpr uint64_t kPrime = 1099511628211ull;
+    uint64_t hash = kOffset;
+};
+
+#endif  // LIBCBCT_HASH_H
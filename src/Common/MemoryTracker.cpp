@@ -0,0 +1,227 @@
+#define LIBCBCT_API_EXPORT
+#include "MemoryTracker.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+std::atomic<bool> MemoryTracker::active{ false };
+
+namespace {
+
+constexpr int kNumCategories = (int)MemoryCategory::NumCategories;
+const char *const kCategoryNames[kNumCategories] = { "volume", "scratch", "io" };
+
+std::atomic<uint64_t> currentBytes[kNumCategories];
+std::atomic<uint64_t> peakBytes[kNumCategories];
+std::atomic<uint64_t> totalBytes{ 0 };
+std::atomic<uint64_t> totalPeak{ 0 };
+std::atomic<uint64_t> stagePeak{ 0 };
+
+/**
+ * Stage in progress on a thread. The counters are reset when any stage begins, so that the peaks since this one began
+ * are the larger of those folded into the frame at the resets and those of the counters.
+ */
+struct StageFrame {
+    const char *name;
+    std::thread::id thread;
+    uint64_t trackedPeak;
+    uint64_t residentPeak;
+};
+
+std::mutex stageMutex;
+std::vector<StageFrame> frames;
+std::vector<MemoryStageRecord> records;
+
+void updateMax(std::atomic<uint64_t> &peak, uint64_t value) {
+    uint64_t prev = peak.load(std::memory_order_relaxed);
+    while (prev < value && !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+    }
+}
+
+std::string formatMiB(uint64_t bytes) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f MiB", (double)bytes / (1024.0 * 1024.0));
+    return buf;
+}
+
+}  // namespace
+
+void MemoryTracker::allocate(MemoryCategory category, uint64_t bytes) {
+    const int c = (int)category;
+    updateMax(peakBytes[c], currentBytes[c].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    const uint64_t total = totalBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    updateMax(totalPeak, total);
+    updateMax(stagePeak, total);
+}
+
+void MemoryTracker::release(MemoryCategory category, uint64_t bytes) {
+    currentBytes[(int)category].fetch_sub(bytes, std::memory_order_relaxed);
+    totalBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::current(MemoryCategory category) {
+    return currentBytes[(int)category].load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::current() {
+    return totalBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::peak(MemoryCategory category) {
+    return peakBytes[(int)category].load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::peak() {
+    return totalPeak.load(std::memory_order_relaxed);
+}
+
+void MemoryTracker::resetPeak() {
+    for (int c = 0; c < kNumCategories; c++) {
+        peakBytes[c].store(currentBytes[c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    totalPeak.store(totalBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemoryTracker::enable(bool on) {
+    active.store(on, std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::residentPeak() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return (uint64_t)counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    unsigned long long kiB = 0;
+    while (std::getline(status, line)) {
+        if (std::sscanf(line.c_str(), "VmHWM: %llu kB", &kiB) == 1) {
+            return (uint64_t)kiB * 1024;
+        }
+    }
+    return 0;
+#endif
+}
+
+bool MemoryTracker::resetResidentPeak() {
+#if defined(__linux__)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5" << std::flush;
+    return !clearRefs.fail();
+#else
+    return false;
+#endif
+}
+
+void MemoryTracker::beginStage(const char *name) {
+    std::lock_guard<std::mutex> lock(stageMutex);
+
+    // Peaks of the stages in progress on any thread are taken before the counters are reset
+    const uint64_t tracked = stagePeak.exchange(current(), std::memory_order_relaxed);
+    const uint64_t resident = frames.empty() ? 0 : residentPeak();
+    for (StageFrame &frame : frames) {
+        frame.trackedPeak = std::max(frame.trackedPeak, tracked);
+        frame.residentPeak = std::max(frame.residentPeak, resident);
+    }
+    frames.push_back({ name, std::this_thread::get_id(), 0, 0 });
+    resetResidentPeak();
+}
+
+void MemoryTracker::endStage() {
+    std::lock_guard<std::mutex> lock(stageMutex);
+
+    // Stages nest on each thread, so that the innermost stage of the calling thread is the one ending
+    const std::thread::id thread = std::this_thread::get_id();
+    const auto it = std::find_if(frames.rbegin(), frames.rend(),
+                                 [&](const StageFrame &frame) { return frame.thread == thread; });
+    if (it == frames.rend()) {
+        return;
+    }
+
+    const StageFrame frame = *it;
+    frames.erase(std::next(it).base());
+
+    MemoryStageRecord record;
+    record.name = frame.name;
+    record.trackedPeak = std::max(frame.trackedPeak, stagePeak.load(std::memory_order_relaxed));
+    record.residentPeak = std::max(frame.residentPeak, residentPeak());
+    records.push_back(record);
+}
+
+std::vector<MemoryStageRecord> MemoryTracker::stages() {
+    std::lock_guard<std::mutex> lock(stageMutex);
+    return records;
+}
+
+MemoryStageRecord MemoryTracker::stage(const std::string &name) {
+    std::lock_guard<std::mutex> lock(stageMutex);
+    MemoryStageRecord result;
+    result.name = name;
+    for (const MemoryStageRecord &r : records) {
+        if (r.name == name) {
+            result.trackedPeak = std::max(result.trackedPeak, r.trackedPeak);
+            result.residentPeak = std::max(result.residentPeak, r.residentPeak);
+        }
+    }
+    return result;
+}
+
+std::string MemoryTracker::report() {
+    std::ostringstream oss;
+    char line[160];
+    const std::vector<MemoryStageRecord> recs = stages();
+    if (!recs.empty()) {
+        std::snprintf(line, sizeof(line), "%-16s %16s %16s", "Stage", "Tracked peak", "Resident peak");
+        oss << line << std::endl;
+        for (const MemoryStageRecord &r : recs) {
+            std::snprintf(line, sizeof(line), "%-16s %16s %16s", r.name.c_str(), formatMiB(r.trackedPeak).c_str(),
+                          formatMiB(r.residentPeak).c_str());
+            oss << line << std::endl;
+        }
+    }
+
+    std::snprintf(line, sizeof(line), "%-16s %16s %16s", "Category", "Current", "Peak");
+    oss << line << std::endl;
+    for (int c = 0; c < kNumCategories; c++) {
+        std::snprintf(line, sizeof(line), "%-16s %16s %16s", kCategoryNames[c],
+                      formatMiB(current((MemoryCategory)c)).c_str(), formatMiB(peak((MemoryCategory)c)).c_str());
+        oss << line << std::endl;
+    }
+    std::snprintf(line, sizeof(line), "%-16s %16s %16s", "total", formatMiB(current()).c_str(),
+                  formatMiB(peak()).c_str());
+    oss << line << std::endl;
+    return oss.str();
+}
+
+void MemoryTracker::clear() {
+    std::lock_guard<std::mutex> lock(stageMutex);
+    records.clear();
+}
+
+MemoryStage::MemoryStage(const char *name)
+    : recording{ MemoryTracker::enabled() } {
+    if (recording) {
+        MemoryTracker::beginStage(name);
+    }
+}
+
+MemoryStage::~MemoryStage() {
+    if (recording) {
+        MemoryTracker::endStage();
+    }
+}
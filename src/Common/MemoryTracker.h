@@ -0,0 +1,149 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_MEMORY_TRACKER_H
+#define LIBCBCT_MEMORY_TRACKER_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Common/Api.h"
+
+//! Owner of the tracked allocations
+enum class MemoryCategory : int {
+    Volume = 0,  // Storage of Volume and BrickedVolume
+    Scratch,     // Buffers of the reconstruction (filter arena, view buffer)
+    IO,          // Buffers of the importers and exporters
+    NumCategories,
+};
+
+//! Peak memory of a pipeline stage
+struct MemoryStageRecord {
+    std::string name;
+    //! Largest sum of the tracked allocations during the stage
+    uint64_t trackedPeak = 0;
+    //! High-water mark of the resident memory during the stage (VmHWM), or zero if unknown
+    uint64_t residentPeak = 0;
+};
+
+/**
+ * @brief Bytes allocated by the volumes, the reconstruction scratch and the I/O buffers, and peaks per stage
+ * @details The current and peak bytes of each category are always counted, which costs two atomic operations per
+ * allocation. When enabled, each stage (see MemoryStage) also records the largest tracked bytes and the high-water
+ * mark of the resident memory during it. The latter is read from VmHWM in /proc/self/status, which is reset to the
+ * current resident memory at the beginning of each stage through /proc/self/clear_refs (Linux 4.0 or later). Where
+ * the reset is not available, the resident peak of a stage is that of the process so far. Stages nest on each thread
+ * and may run on several threads at once, but both peaks are of the whole process: those of a stage include the
+ * allocations of the other threads during it, e.g., of the OpenMP workers or of the stages running concurrently.
+ */
+class LIBCBCT_API MemoryTracker {
+public:
+    static void allocate(MemoryCategory category, uint64_t bytes);
+    static void release(MemoryCategory category, uint64_t bytes);
+
+    //! Bytes currently allocated in a category, or in all of them
+    static uint64_t current(MemoryCategory category);
+    static uint64_t current();
+
+    //! Largest bytes allocated at once in a category, or in all of them, since the last resetPeak()
+    static uint64_t peak(MemoryCategory category);
+    static uint64_t peak();
+    static void resetPeak();
+
+    //! Enable the stage records, which reset the resident high-water mark of the process
+    static void enable(bool on = true);
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    //! High-water mark of the resident memory (VmHWM on Linux, peak working set on Windows), or zero if unknown
+    static uint64_t residentPeak();
+
+    //! Reset the high-water mark to the current resident memory, returning false if not supported
+    static bool resetResidentPeak();
+
+    static void beginStage(const char *name);
+    static void endStage();
+
+    //! Records of the finished stages, in the order they finished
+    static std::vector<MemoryStageRecord> stages();
+
+    //! Largest peaks of the stages with the given name, or empty records if there is none
+    static MemoryStageRecord stage(const std::string &name);
+
+    //! Table of the stages and of the current and peak bytes of each category
+    static std::string report();
+
+    static void clear();
+
+private:
+    static std::atomic<bool> active;
+};
+
+//! Stage recorded from the construction to the destruction, when the tracker is enabled
+class LIBCBCT_API MemoryStage {
+public:
+    explicit MemoryStage(const char *name);
+    MemoryStage(const MemoryStage &) = delete;
+    MemoryStage &operator=(const MemoryStage &) = delete;
+    ~MemoryStage();
+
+private:
+    bool recording;
+};
+
+//! Bytes held by the buffers that are not allocated through allocateTracked(), e.g., images of OpenCV
+class LIBCBCT_API MemoryReservation {
+public:
+    MemoryReservation(MemoryCategory category, uint64_t bytes)
+        : category{ category }
+        , bytes{ bytes } {
+        MemoryTracker::allocate(category, bytes);
+    }
+    MemoryReservation(const MemoryReservation &) = delete;
+    MemoryReservation &operator=(const MemoryReservation &) = delete;
+    ~MemoryReservation() {
+        MemoryTracker::release(category, bytes);
+    }
+
+private:
+    MemoryCategory category;
+    uint64_t bytes;
+};
+
+//! Deleter of the arrays from allocateTracked()
+struct TrackedDelete {
+    MemoryCategory category = MemoryCategory::Volume;
+    uint64_t bytes = 0;
+
+    template <typename T>
+    void operator()(T *ptr) const {
+        if (ptr != nullptr) {
+            delete[] ptr;
+            MemoryTracker::release(category, bytes);
+        }
+    }
+};
+
+template <typename T>
+using TrackedArray = std::unique_ptr<T[], TrackedDelete>;
+
+//! Zero-initialized array counted in the given category until it is deleted
+template <typename T>
+TrackedArray<T> allocateTracked(uint64_t count, MemoryCategory category) {
+    TrackedArray<T> array(new T[count](), TrackedDelete{ category, sizeof(T) * count });
+    MemoryTracker::allocate(category, sizeof(T) * count);
+    return array;
+}
+
+#define LIBCBCT_MEMORY_CONCAT_(A, B) A##B
+#define LIBCBCT_MEMORY_CONCAT(A, B) LIBCBCT_MEMORY_CONCAT_(A, B)
+
+#define LIBCBCT_MEMORY_STAGE(NAME) MemoryStage LIBCBCT_MEMORY_CONCAT(memoryStage_, __LINE__)(NAME)
+
+#endif  // LIBCBCT_MEMORY_TRACKER_H
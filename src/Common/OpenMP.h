@@ -9,6 +9,7 @@
 #include <omp.h>
 #if defined(_MSC_VER)
 #define OMP_PRAGMA __pragma(omp parallel for)
+#define OMP_SIMD
 #define OMP_CRITICAL __pragma(omp critical)
 #define OMP_ATOMIC(expression)           \
     do {                                 \
@@ -16,6 +17,7 @@
     } while (1);
 #else
 #define OMP_PRAGMA _Pragma("omp parallel for")
+#define OMP_SIMD _Pragma("omp simd")
 #define OMP_CRITICAL _Pragma("omp parallel for")
 #define OMP_ATOMIC(expression)            \
     do {                                  \
@@ -34,6 +36,7 @@
 #define omp_get_max_threads() 1
 #define omp_get_num_threads() 1
 #define OMP_PARALLEL_FOR for
+#define OMP_SIMD
 #define OMP_CRITICAL
 #define OMP_ATOMIC(expression)
 #define omp_critical
@@ -0,0 +1,63 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_PARALLEL_H
+#define LIBCBCT_PARALLEL_H
+
+#include <cstdint>
+#include <algorithm>
+
+#include "Common/OpenMP.h"
+
+//! Default number of elements processed by a task of the chunked loops (256 KiB of float)
+constexpr uint64_t kParallelChunkSize = 64 * 1024;
+
+/**
+ * @brief Parallel loop over [0, count) split into contiguous chunks
+ * @details The callable is invoked as func(chunk, begin, end) for each chunk. Chunk boundaries depend only on
+ * the count and the chunk size, so that per-chunk partial results can be combined in a deterministic order.
+ */
+template <typename Func>
+void parallelForChunks(uint64_t count, Func &&func, uint64_t chunkSize = kParallelChunkSize) {
+    const int64_t nChunks = (int64_t)((count + chunkSize - 1) / chunkSize);
+    OMP_PARALLEL_FOR(int64_t c = 0; c < nChunks; c++) {
+        const uint64_t begin = (uint64_t)c * chunkSize;
+        const uint64_t end = std::min(count, begin + chunkSize);
+        func(c, begin, end);
+    }
+}
+
+//! Number of chunks visited by parallelForChunks
+inline uint64_t numParallelChunks(uint64_t count, uint64_t chunkSize = kParallelChunkSize) {
+    return (count + chunkSize - 1) / chunkSize;
+}
+
+/**
+ * @brief Number of threads of the parallel loops started by the calling thread within a scope
+ * @details A count of zero or less leaves the number unchanged. The previous number is restored at the end of the
+ * scope, so that a stage can run with its own thread count without affecting the others.
+ */
+class ScopedThreadCount {
+public:
+    explicit ScopedThreadCount(int threads)
+        : previous{ omp_get_max_threads() }
+        , changed{ threads > 0 && threads != previous } {
+        if (changed) {
+            omp_set_num_threads(threads);
+        }
+    }
+    ScopedThreadCount(const ScopedThreadCount &) = delete;
+    ScopedThreadCount &operator=(const ScopedThreadCount &) = delete;
+    ~ScopedThreadCount() {
+        if (changed) {
+            omp_set_num_threads(previous);
+        }
+    }
+
+private:
+    int previous;
+    bool changed;
+};
+
+#endif  // LIBCBCT_PARALLEL_H
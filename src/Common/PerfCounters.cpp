@@ -0,0 +1,227 @@
+#define LIBCBCT_API_EXPORT
+#include "PerfCounters.h"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+
+std::atomic<bool> PerfCounters::active{ false };
+
+namespace {
+
+constexpr int kNumEvents = 3;
+
+//! Counter group of a thread, which is closed when the thread exits
+struct ThreadCounters {
+    int fds[kNumEvents] = { -1, -1, -1 };
+    bool tried = false;
+    bool ok = false;
+
+    ~ThreadCounters() {
+        close();
+    }
+
+    bool open() {
+        if (tried) {
+            return ok;
+        }
+        tried = true;
+
+#if defined(__linux__)
+        const uint64_t configs[kNumEvents] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                               PERF_COUNT_HW_CACHE_MISSES };
+        for (int k = 0; k < kNumEvents; k++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[k];
+            attr.disabled = k == 0 ? 1 : 0;  // The group is started at once through the leader
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[k] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, k == 0 ? -1 : fds[0], 0);
+            if (fds[k] < 0) {
+                close();
+                return false;
+            }
+        }
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        ok = true;
+#endif
+        return ok;
+    }
+
+    bool read(PerfSample &sample) {
+        if (!open()) {
+            return false;
+        }
+
+#if defined(__linux__)
+        struct {
+            uint64_t nr;
+            uint64_t timeEnabled;
+            uint64_t timeRunning;
+            uint64_t values[kNumEvents];
+        } data;
+        if (::read(fds[0], &data, sizeof(data)) != (ssize_t)sizeof(data) || data.nr != kNumEvents) {
+            return false;
+        }
+
+        // Counts are extrapolated when the group was multiplexed with other events
+        const double scale = data.timeRunning > 0 ? (double)data.timeEnabled / (double)data.timeRunning : 0.0;
+        sample.cycles = (uint64_t)(data.values[0] * scale);
+        sample.instructions = (uint64_t)(data.values[1] * scale);
+        sample.llcMisses = (uint64_t)(data.values[2] * scale);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void close() {
+        for (int k = 0; k < kNumEvents; k++) {
+#if defined(__linux__)
+            if (fds[k] >= 0) {
+                ::close(fds[k]);
+            }
+#endif
+            fds[k] = -1;
+        }
+        ok = false;
+    }
+};
+
+thread_local ThreadCounters threadCounters;
+
+struct RegionStats {
+    const char *name;
+    uint64_t calls = 0;
+    uint64_t timeNs = 0;
+    uint64_t voxelUpdates = 0;
+    PerfSample counts;
+};
+
+std::mutex statsMutex;
+std::vector<RegionStats> regionStats;
+
+uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
+bool PerfCounters::enable(bool on) {
+    if (on && !threadCounters.open()) {
+        LIBCBCT_WARN("Hardware performance counters are not available (see /proc/sys/kernel/perf_event_paranoid)");
+        on = false;
+    }
+    active.store(on, std::memory_order_relaxed);
+    return on;
+}
+
+bool PerfCounters::read(PerfSample &sample) {
+    return threadCounters.read(sample);
+}
+
+void PerfCounters::readThreads(std::vector<PerfSample> &samples) {
+    // With as many iterations as threads, each thread of the team reads its own counters
+    const int nThreads = omp_get_max_threads();
+    samples.assign(nThreads, PerfSample());
+    OMP_PARALLEL_FOR(int t = 0; t < nThreads; t++) {
+        PerfSample sample;
+        if (read(sample)) {
+            samples[omp_get_thread_num()] = sample;
+        }
+    }
+}
+
+void PerfCounters::record(const char *name, const PerfSample &delta, uint64_t timeNs, uint64_t voxelUpdates) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    auto it = std::find_if(regionStats.begin(), regionStats.end(),
+                           [&](const RegionStats &r) { return std::strcmp(r.name, name) == 0; });
+    if (it == regionStats.end()) {
+        regionStats.push_back({ name });
+        it = regionStats.end() - 1;
+    }
+    it->calls += 1;
+    it->timeNs += timeNs;
+    it->voxelUpdates += voxelUpdates;
+    it->counts.cycles += delta.cycles;
+    it->counts.instructions += delta.instructions;
+    it->counts.llcMisses += delta.llcMisses;
+}
+
+std::string PerfCounters::report() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    std::string table;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-14s %8s %12s %10s %6s %12s %12s %10s %8s\n", "Region", "Calls", "Time [ms]",
+                  "Cycles [G]", "IPC", "LLC miss [M]", "DRAM [MB]", "Bytes/VU", "GVU/s");
+    table += line;
+    for (const RegionStats &r : regionStats) {
+        const double dramBytes = (double)r.counts.llcMisses * kCacheLineBytes;
+        const double ipc = r.counts.cycles > 0 ? (double)r.counts.instructions / r.counts.cycles : 0.0;
+        char perVoxel[32] = "-", gvus[32] = "-";
+        if (r.voxelUpdates > 0) {
+            std::snprintf(perVoxel, sizeof(perVoxel), "%.3f", dramBytes / r.voxelUpdates);
+            std::snprintf(gvus, sizeof(gvus), "%.3f", r.timeNs > 0 ? (double)r.voxelUpdates / r.timeNs : 0.0);
+        }
+        std::snprintf(line, sizeof(line), "%-14s %8llu %12.3f %10.3f %6.2f %12.3f %12.3f %10s %8s\n", r.name,
+                      (unsigned long long)r.calls, r.timeNs * 1.0e-6, r.counts.cycles * 1.0e-9, ipc,
+                      r.counts.llcMisses * 1.0e-6, dramBytes / (1024.0 * 1024.0), perVoxel, gvus);
+        table += line;
+    }
+    return table;
+}
+
+void PerfCounters::clear() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    regionStats.clear();
+}
+
+PerfRegion::PerfRegion(const char *name, uint64_t voxelUpdates)
+    : name{ PerfCounters::enabled() ? name : nullptr }
+    , voxelUpdates{ voxelUpdates } {
+    if (this->name) {
+        PerfCounters::readThreads(samples);
+        begin = nowNs();
+    }
+}
+
+PerfRegion::~PerfRegion() {
+    if (!name) {
+        return;
+    }
+
+    const uint64_t end = nowNs();
+    std::vector<PerfSample> after;
+    PerfCounters::readThreads(after);
+
+    // Threads which opened their counters inside the region are skipped, as they have no starting values
+    PerfSample delta;
+    for (size_t t = 0; t < std::min(samples.size(), after.size()); t++) {
+        if (samples[t].cycles == 0 || after[t].cycles < samples[t].cycles) {
+            continue;
+        }
+        delta.cycles += after[t].cycles - samples[t].cycles;
+        delta.instructions += after[t].instructions - samples[t].instructions;
+        delta.llcMisses += after[t].llcMisses - samples[t].llcMisses;
+    }
+    PerfCounters::record(name, delta, end - begin, voxelUpdates);
+}
@@ -0,0 +1,87 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_PERF_COUNTERS_H
+#define LIBCBCT_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <vector>
+
+#include "Common/Api.h"
+
+//! Hardware counters summed over the threads
+struct PerfSample {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t llcMisses = 0;
+};
+
+/**
+ * @brief Hardware performance counters of named regions (Linux perf_event_open)
+ * @details Each thread opens its own group of user-space counters (cycles, instructions and last-level cache
+ * misses) on its first use. A region reads the counters of all the OpenMP threads when it begins and ends, and the
+ * differences are accumulated per region name together with the wall time and the number of voxel updates.
+ * DRAM traffic is estimated as the LLC misses times the cache-line size, since the memory-controller counters
+ * require system-wide privileges. Without the kernel support (or permission, see perf_event_paranoid), the
+ * counters are unavailable and the regions record nothing.
+ */
+class LIBCBCT_API PerfCounters {
+public:
+    static constexpr uint64_t kCacheLineBytes = 64;
+
+    //! Enable the regions, returning false if the counters cannot be opened
+    static bool enable(bool on = true);
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    //! Counters of the calling thread since it opened them (false if unavailable)
+    static bool read(PerfSample &sample);
+
+    //! Counters of each OpenMP thread, read in a parallel region
+    static void readThreads(std::vector<PerfSample> &samples);
+
+    static void record(const char *name, const PerfSample &delta, uint64_t timeNs, uint64_t voxelUpdates);
+
+    /**
+     * @brief Table of the regions with the derived metrics
+     * @details IPC is instructions per cycle, bytes/VU is the estimated DRAM bytes per voxel update, and GVU/s is
+     * giga voxel updates per second of wall time.
+     */
+    static std::string report();
+
+    static void clear();
+
+private:
+    static std::atomic<bool> active;
+};
+
+//! Region measured from the construction to the destruction, when the counters are enabled
+class LIBCBCT_API PerfRegion {
+public:
+    explicit PerfRegion(const char *name, uint64_t voxelUpdates = 0);
+    PerfRegion(const PerfRegion &) = delete;
+    PerfRegion &operator=(const PerfRegion &) = delete;
+    ~PerfRegion();
+
+private:
+    const char *name;
+    uint64_t voxelUpdates;
+    uint64_t begin = 0;
+    std::vector<PerfSample> samples;
+};
+
+#define LIBCBCT_PERF_CONCAT_(A, B) A##B
+#define LIBCBCT_PERF_CONCAT(A, B) LIBCBCT_PERF_CONCAT_(A, B)
+
+#if !defined(LIBCBCT_DISABLE_PERF)
+#define LIBCBCT_PERF_REGION(NAME, VOXELS) PerfRegion LIBCBCT_PERF_CONCAT(perfRegion_, __LINE__)(NAME, VOXELS)
+#else
+#define LIBCBCT_PERF_REGION(NAME, VOXELS)
+#endif
+
+#endif  // LIBCBCT_PERF_COUNTERS_H
@@ -5,25 +5,40 @@
 #ifndef PROGRESS_BAR_H
 #define PROGRESS_BAR_H
 
-#include <iostream>
+#include <cstdio>
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <sstream>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
 
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Console progress bar which can be stepped from the hot loops of any number of threads
+ * @details step() only increments an atomic counter. The bar is drawn by a background ticker every
+ * kRefreshInterval when stdout is a terminal, and the thread completing the bar draws the final line. When stdout
+ * is redirected, only the final line is printed, so that the logs are not flooded with carriage returns.
+ */
 class ProgressBar {
 public:
+    static constexpr std::chrono::milliseconds kRefreshInterval{ 100 };
+
     ProgressBar() {
     }
 
     ProgressBar(int total) {
-        m_step = 0;
-        m_total = total;
-        m_start = std::chrono::system_clock::now();
+        reset(total);
     }
 
     virtual ~ProgressBar() {
+        stopTicker();
     }
 
     void setWidth(int width) {
@@ -34,69 +49,131 @@ public:
     void setDescription(const char *format, const Args &...args) {
         const int len = snprintf(NULL, 0, format, args...);
 
-        char *buf = new char[len];
-        snprintf(buf, len, format, args...);
-        m_description = std::string(buf);
-        delete[] buf;
+        std::string buf(len + 1, '\0');
+        snprintf(&buf[0], len + 1, format, args...);
+        buf.resize(len);
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_description = buf;
     }
 
     void step(int n = 1) {
-        std::lock_guard<std::mutex> lock(m_mtx);
+        const int prev = m_step.fetch_add(n, std::memory_order_relaxed);
+        if (prev < m_total && prev + n >= m_total) {
+            // Only the thread crossing the total reaches here
+            std::lock_guard<std::mutex> lock(m_mtx);
+            render(m_total, true);
+            m_completed = true;
+            m_done = true;
+            m_cond.notify_all();
+        }
+    }
+
+    void finish() {
+        const int current = m_step.load(std::memory_order_relaxed);
+        if (current < m_total) {
+            step(m_total - current);
+        }
+    }
+
+    void reset(int total = 0) {
+        stopTicker();
+        m_step.store(0, std::memory_order_relaxed);
+        m_total = total != 0 ? total : m_total;
+        m_start = std::chrono::steady_clock::now();
+        m_done = false;
+        m_drawn = false;
+        m_completed = false;
+        if (m_total > 0 && isTerminal()) {
+            m_ticker = std::thread([this] { tick(); });
+        }
+    }
+
+private:
+    static bool isTerminal() {
+#if defined(_WIN32)
+        return _isatty(_fileno(stdout)) != 0;
+#else
+        return isatty(fileno(stdout)) != 0;
+#endif
+    }
+
+    void tick() {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        while (!m_done) {
+            render(std::min(m_step.load(std::memory_order_relaxed), m_total), false);
+            m_cond.wait_for(lock, kRefreshInterval, [this] { return m_done; });
+        }
+    }
 
-        m_step += n;
-        auto now = std::chrono::system_clock::now();
+    void stopTicker() {
+        if (m_ticker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                m_done = true;
+            }
+            m_cond.notify_all();
+            m_ticker.join();
+        }
 
-        const double percent = 100.0 * m_step / m_total;
+        // Terminate the line of a bar left incomplete (e.g., by a cancellation)
+        if (m_drawn && !m_completed) {
+            printf("\n");
+            fflush(stdout);
+            m_drawn = false;
+        }
+    }
+
+    //! Draw the bar with the given number of steps, which is called with the mutex held
+    void render(int current, bool last) {
+        if (!last && current == 0) {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const double percent = 100.0 * current / m_total;
         const int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start).count();
-        const double time_msec_per_step = (double)elapsed / (double)m_step;
-        const double rest_time = time_msec_per_step * (m_total - m_step);
+        const double time_msec_per_step = current > 0 ? (double)elapsed / (double)current : 0.0;
+        const double rest_time = time_msec_per_step * (m_total - current);
 
         const int n_min = (int)(elapsed / 1000.0) / 60;
         const int n_sec = (int)(elapsed / 1000.0) % 60;
         const int r_min = (int)(rest_time / 1000.0) / 60;
         const int r_sec = (int)(rest_time / 1000.0) % 60;
 
-        const int steps_per_sec = (int)(1000.0 / time_msec_per_step);
-        std::ostringstream oss;
-        oss << steps_per_sec;
-        const std::string it_text = steps_per_sec < 1000 ? oss.str() : "1000+";
+        char it_text[16];
+        if (time_msec_per_step <= 1.0) {
+            snprintf(it_text, sizeof(it_text), "1000+");
+        } else {
+            snprintf(it_text, sizeof(it_text), "%d", (int)(1000.0 / time_msec_per_step));
+        }
 
-        const int tick = (int)(m_width * m_step / m_total);
+        const int tick = (int)((int64_t)m_width * current / m_total);
         std::string pbar = std::string(tick, '=');
         if (tick != m_width) {
             pbar += ">";
             pbar += std::string(m_width - tick - 1, ' ');
         }
 
-        if (m_step == m_total || m_step % std::max(1, m_total / 1000) == 0) {
-            printf("\r%s [%3d%%]|%s| %d/%d [%02d:%02d<%02d:%02d, %sit/s]", m_description.c_str(), (int)percent,
-                   pbar.c_str(), m_step, m_total, n_min, n_sec, r_min, r_sec, it_text.c_str());
-        }
-
-        if (m_step == m_total) {
+        printf("\r%s[%3d%%]|%s| %d/%d [%02d:%02d<%02d:%02d, %sit/s]", m_description.c_str(), (int)percent,
+               pbar.c_str(), current, m_total, n_min, n_sec, r_min, r_sec, it_text);
+        if (last) {
             printf("\n");
         }
         fflush(stdout);
+        m_drawn = true;
     }
 
-    void finish() {
-        if (m_step != m_total) {
-            step(m_total - m_step);
-        }
-    }
-
-    void reset(int total = 0) {
-        m_step = 0;
-        m_total = total != 0 ? total : m_total;
-        m_start = std::chrono::system_clock::now();        
-    }
-
-private:
     int m_width = 40;
-    int m_step, m_total;
+    std::atomic<int> m_step{ 0 };
+    int m_total = 0;
     std::string m_description = "";
-    std::chrono::system_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_done = false;
+    bool m_drawn = false;
+    bool m_completed = false;
     std::mutex m_mtx;
+    std::condition_variable m_cond;
+    std::thread m_ticker;
 };
 
 #endif  // PROGRESS_BAR_H
@@ -0,0 +1,254 @@
+#define LIBCBCT_API_EXPORT
+#include "Roofline.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <fstream>
+#include <memory>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <nlohmann/json.hpp>
+
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+#include "Common/Parallel.h"
+#include "Common/Timing.h"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+//! Floats per array of the triad, so that the three arrays (384 MiB) do not fit in the last-level cache
+constexpr uint64_t kTriadLength = 32ull << 20;
+constexpr int kTriadRuns = 5;
+
+//! Independent accumulators per thread, enough to hide the latency of the multiply-adds
+constexpr int kFmaLanes = 64;
+constexpr int kFmaIterations = 1 << 20;
+constexpr int kFmaRuns = 3;
+
+double measureBandwidth() {
+    // Pages are first touched by the threads that stream them, as in the reconstruction
+    std::unique_ptr<float[]> a(new float[kTriadLength]);
+    std::unique_ptr<float[]> b(new float[kTriadLength]);
+    std::unique_ptr<float[]> c(new float[kTriadLength]);
+    parallelForChunks(kTriadLength, [&](int64_t, uint64_t begin, uint64_t end) {
+        std::fill(a.get() + begin, a.get() + end, 0.0f);
+        std::fill(b.get() + begin, b.get() + end, 1.0f);
+        std::fill(c.get() + begin, c.get() + end, 2.0f);
+    });
+
+    // Two floats read and one written per element, without the write-allocate traffic (as STREAM counts it)
+    const float scalar = 3.0f;
+    const double seconds = bestOf(kTriadRuns, [&] {
+        parallelForChunks(kTriadLength, [&](int64_t, uint64_t begin, uint64_t end) {
+            float *const pa = a.get();
+            const float *const pb = b.get();
+            const float *const pc = c.get();
+            OMP_SIMD
+            for (uint64_t i = begin; i < end; i++) {
+                pa[i] = pb[i] + scalar * pc[i];
+            }
+        });
+    });
+
+    volatile float sink = a[kTriadLength / 2];
+    (void)sink;
+    return 3.0 * sizeof(float) * kTriadLength / seconds * 1.0e-9;
+}
+
+double measurePeakFlops(int threads) {
+    std::vector<float> sinks(threads);
+    const double seconds = bestOf(kFmaRuns, [&] {
+        OMP_PARALLEL_FOR(int t = 0; t < threads; t++) {
+            float acc[kFmaLanes];
+            for (int k = 0; k < kFmaLanes; k++) {
+                acc[k] = (float)(t + k);
+            }
+            const float mul = 0.999999f;
+            const float add = 1.0e-6f;
+            for (int it = 0; it < kFmaIterations; it++) {
+                OMP_SIMD
+                for (int k = 0; k < kFmaLanes; k++) {
+                    acc[k] = acc[k] * mul + add;
+                }
+            }
+            float sum = 0.0f;
+            for (int k = 0; k < kFmaLanes; k++) {
+                sum += acc[k];
+            }
+            sinks[t] = sum;
+        }
+    });
+
+    volatile float sink = sinks[0];
+    (void)sink;
+    return 2.0 * kFmaLanes * kFmaIterations * threads / seconds * 1.0e-9;
+}
+
+std::string calibrationPath() {
+    return (fs::path(HostCalibration::cacheDirectory()) / ("calibration-" + HostCalibration::hostName() + ".json"))
+        .string();
+}
+
+bool loadCalibration(const std::string &path, int threads, HostCalibration &calib) {
+    std::ifstream reader(path.c_str(), std::ios::in);
+    if (reader.fail()) {
+        return false;
+    }
+    const json root = json::parse(reader, nullptr, false);
+    if (root.is_discarded() || root.value("threads", 0) != threads) {
+        return false;
+    }
+    calib.threads = threads;
+    calib.bandwidthGBs = root.value("bandwidthGBs", 0.0);
+    calib.peakGflops = root.value("peakGflops", 0.0);
+    return calib.bandwidthGBs > 0.0 && calib.peakGflops > 0.0;
+}
+
+void saveCalibration(const std::string &path, const HostCalibration &calib) {
+    std::ofstream writer(path.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_WARN("Failed to save the host calibration: %s", path.c_str());
+        return;
+    }
+    const json root = { { "host", calib.host },
+                        { "threads", calib.threads },
+                        { "bandwidthGBs", calib.bandwidthGBs },
+                        { "peakGflops", calib.peakGflops } };
+    writer << root.dump(2) << std::endl;
+}
+
+}  // namespace
+
+HostCalibration HostCalibration::get() {
+    static std::mutex mutex;
+    static HostCalibration calib;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const int threads = omp_get_max_threads();
+    if (calib.threads == threads) {
+        return calib;
+    }
+
+    const std::string path = calibrationPath();
+    calib.host = hostName();
+    if (loadCalibration(path, threads, calib)) {
+        LIBCBCT_DEBUG("Host calibration loaded: %s", path.c_str());
+        return calib;
+    }
+
+    LIBCBCT_INFO("Calibrating the host for %d threads...", threads);
+    calib = measure();
+    saveCalibration(path, calib);
+    return calib;
+}
+
+HostCalibration HostCalibration::measure() {
+    HostCalibration calib;
+    calib.host = hostName();
+    calib.threads = omp_get_max_threads();
+    calib.bandwidthGBs = measureBandwidth();
+    calib.peakGflops = measurePeakFlops(calib.threads);
+    LIBCBCT_INFO("Host calibration: %.1f GB/s, %.1f GFLOP/s (%d threads)", calib.bandwidthGBs, calib.peakGflops,
+                 calib.threads);
+    return calib;
+}
+
+std::string HostCalibration::hostName() {
+    char name[256] = {};
+#if defined(_WIN32)
+    DWORD size = sizeof(name);
+    if (!GetComputerNameA(name, &size)) {
+        return "localhost";
+    }
+#else
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') {
+        return "localhost";
+    }
+#endif
+    // Only the characters that are safe in a file name are kept
+    std::string host = name;
+    for (char &ch : host) {
+        if (!std::isalnum((unsigned char)ch) && ch != '-' && ch != '.') {
+            ch = '_';
+        }
+    }
+    return host;
+}
+
+std::string HostCalibration::cacheDirectory() {
+    fs::path dir;
+    if (const char *env = std::getenv("LIBCBCT_CACHE_DIR")) {
+        dir = env;
+    } else {
+#if defined(_WIN32)
+        const char *base = std::getenv("LOCALAPPDATA");
+        dir = fs::path(base != nullptr ? base : ".") / "libcbct";
+#else
+        if (const char *xdg = std::getenv("XDG_CACHE_HOME")) {
+            dir = fs::path(xdg) / "libcbct";
+        } else {
+            const char *home = std::getenv("HOME");
+            dir = fs::path(home != nullptr ? home : ".") / ".cache" / "libcbct";
+        }
+#endif
+    }
+
+    std::error_code error;
+    fs::create_directories(dir, error);
+    if (error) {
+        LIBCBCT_WARN("Failed to create the cache directory: %s", dir.string().c_str());
+    }
+    return dir.string();
+}
+
+RooflineReport RooflineReport::evaluate(double voxelUpdates, double bytes, double flops, double seconds,
+                                        const HostCalibration &host) {
+    RooflineReport report;
+    report.host = host;
+    report.seconds = seconds;
+    if (seconds <= 0.0 || bytes <= 0.0) {
+        return report;
+    }
+
+    report.voxelUpdatesPerSec = voxelUpdates / seconds;
+    report.bandwidthGBs = bytes / seconds * 1.0e-9;
+    report.gflops = flops / seconds * 1.0e-9;
+    report.arithmeticIntensity = flops / bytes;
+    report.attainableGflops = std::min(host.peakGflops, report.arithmeticIntensity * host.bandwidthGBs);
+    report.memoryBound = report.arithmeticIntensity * host.bandwidthGBs < host.peakGflops;
+    return report;
+}
+
+std::string RooflineReport::summary() const {
+    const double ridge = host.bandwidthGBs > 0.0 ? host.peakGflops / host.bandwidthGBs : 0.0;
+    const double fracBw = host.bandwidthGBs > 0.0 ? bandwidthGBs / host.bandwidthGBs : 0.0;
+    const double fracPeak = host.peakGflops > 0.0 ? gflops / host.peakGflops : 0.0;
+    const double attainableVUs = gflops > 0.0 ? voxelUpdatesPerSec * attainableGflops / gflops : 0.0;
+
+    char buf[512];
+    std::snprintf(buf, sizeof(buf),
+                  "Roofline: %.3f GVU/s in %.3f sec (attainable %.3f GVU/s, %.1f%%)\n"
+                  "  Memory : %.2f GB/s of %.2f GB/s (%.1f%%)\n"
+                  "  Compute: %.2f GFLOP/s of %.2f GFLOP/s (%.1f%%)\n"
+                  "  Intensity %.2f FLOP/byte vs ridge point %.2f FLOP/byte: %s-bound",
+                  voxelUpdatesPerSec * 1.0e-9, seconds, attainableVUs * 1.0e-9, 100.0 * efficiency(), bandwidthGBs,
+                  host.bandwidthGBs, 100.0 * fracBw, gflops, host.peakGflops, 100.0 * fracPeak, arithmeticIntensity,
+                  ridge, memoryBound ? "memory" : "compute");
+    return buf;
+}
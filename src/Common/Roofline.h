@@ -0,0 +1,72 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_ROOFLINE_H
+#define LIBCBCT_ROOFLINE_H
+
+#include <string>
+
+#include "Common/Api.h"
+
+/**
+ * @brief Streaming bandwidth and peak FLOP rate of the host
+ * @details The bandwidth is that of a STREAM-like triad over arrays much larger than the caches, and the FLOP rate
+ * that of independent single-precision multiply-adds, both with all the OpenMP threads. The calibration takes a
+ * fraction of a second, and get() measures it only once per host and thread count: the result is kept in
+ * calibration-<host>.json in the cache directory, which is read by the later processes.
+ */
+struct LIBCBCT_API HostCalibration {
+    std::string host;
+    int threads = 0;
+    double bandwidthGBs = 0.0;
+    double peakGflops = 0.0;
+
+    /**
+     * @brief Calibration of this host, measured on the first call if the cache has none for the current thread count
+     * @details A copy is returned, since the calibration is measured again when the thread count changes.
+     */
+    static HostCalibration get();
+
+    //! Measure the calibration now, without the cache
+    static HostCalibration measure();
+
+    //! Name of this host, used to name its cache files
+    static std::string hostName();
+
+    /**
+     * @brief Directory of the per-host cache files, which is created if needed
+     * @details LIBCBCT_CACHE_DIR if set, otherwise libcbct in XDG_CACHE_HOME, ~/.cache or %LOCALAPPDATA%.
+     */
+    static std::string cacheDirectory();
+};
+
+/**
+ * @brief Achieved throughput of a run against the roofline of the host
+ * @details The attainable FLOP rate is min(peak FLOP rate, arithmetic intensity x bandwidth), and the run is
+ * memory-bound when its arithmetic intensity is below the ridge point (peak / bandwidth). The byte and FLOP counts
+ * are estimates given by the caller.
+ */
+struct LIBCBCT_API RooflineReport {
+    double seconds = 0.0;
+    double voxelUpdatesPerSec = 0.0;
+    double bandwidthGBs = 0.0;
+    double gflops = 0.0;
+    double arithmeticIntensity = 0.0;
+    double attainableGflops = 0.0;
+    bool memoryBound = false;
+    HostCalibration host;
+
+    static RooflineReport evaluate(double voxelUpdates, double bytes, double flops, double seconds,
+                                   const HostCalibration &host);
+
+    //! Fraction of the attainable FLOP rate that was achieved
+    double efficiency() const {
+        return attainableGflops > 0.0 ? gflops / attainableGflops : 0.0;
+    }
+
+    //! Lines summarizing the report for the log
+    std::string summary() const;
+};
+
+#endif  // LIBCBCT_ROOFLINE_H
@@ -0,0 +1,30 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_TIMING_H
+#define LIBCBCT_TIMING_H
+
+#include <chrono>
+#include <algorithm>
+
+/**
+ * @brief Shortest duration of a call in seconds
+ * @details The call is repeated at least the given number of times, and until the calls took minSeconds in total, so
+ * that short calls are timed often enough to be stable. Warm-up runs are left to the caller.
+ */
+template <typename Func>
+double bestOf(int runs, Func &&func, double minSeconds = 0.0) {
+    double best = 1.0e30, total = 0.0;
+    for (int r = 0; r < runs || total < minSeconds; r++) {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        best = std::min(best, seconds);
+        total += seconds;
+    }
+    return best;
+}
+
+#endif  // LIBCBCT_TIMING_H
@@ -0,0 +1,146 @@
+#define LIBCBCT_API_EXPORT
+#include "Trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+#include "Common/Logging.h"
+
+std::atomic<bool> Tracer::active{ false };
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+struct ThreadBuffer {
+    int tid;
+    std::vector<TraceEvent> events;
+};
+
+const std::chrono::steady_clock::time_point kEpoch = std::chrono::steady_clock::now();
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+thread_local ThreadBuffer *localBuffer = nullptr;
+
+//! Buffer of the calling thread, which is registered on the first span and kept after the thread exits
+ThreadBuffer &threadBuffer() {
+    if (localBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(std::make_unique<ThreadBuffer>());
+        localBuffer = registry.back().get();
+        localBuffer->tid = (int)registry.size() - 1;
+        localBuffer->events.reserve(4096);
+    }
+    return *localBuffer;
+}
+
+}  // namespace
+
+void Tracer::enable(bool on) {
+    active.store(on, std::memory_order_relaxed);
+}
+
+uint64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kEpoch).count();
+}
+
+void Tracer::record(const char *name, uint64_t beginNs, uint64_t endNs) {
+    threadBuffer().events.push_back({ name, beginNs, endNs });
+}
+
+void Tracer::writeChromeTrace(const std::string &filename) {
+    std::FILE *fp = std::fopen(filename.c_str(), "w");
+    if (fp == nullptr) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::fprintf(fp, "{\"traceEvents\":[\n");
+    std::fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"cbct\"}}");
+    for (const auto &buffer : registry) {
+        std::fprintf(fp,
+                     ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+                     "\"args\":{\"name\":\"thread %d\"}}",
+                     buffer->tid, buffer->tid);
+        for (const TraceEvent &e : buffer->events) {
+            // Timestamps are in microseconds
+            std::fprintf(fp,
+                         ",\n{\"name\":\"%s\",\"cat\":\"cbct\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+                         "\"ts\":%.3f,\"dur\":%.3f}",
+                         e.name, buffer->tid, e.begin * 1.0e-3, (e.end - e.begin) * 1.0e-3);
+        }
+    }
+    std::fprintf(fp, "\n]}\n");
+
+    if (std::ferror(fp)) {
+        LIBCBCT_ERROR("Failed to write file: %s", filename.c_str());
+    }
+    std::fclose(fp);
+}
+
+std::string Tracer::summary() {
+    struct Row {
+        const char *name;
+        uint64_t first;
+        uint64_t count = 0;
+        uint64_t total = 0;
+        uint64_t max = 0;
+    };
+
+    std::vector<Row> rows;
+    uint64_t wallBegin = UINT64_MAX, wallEnd = 0;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto &buffer : registry) {
+            for (const TraceEvent &e : buffer->events) {
+                auto it = std::find_if(rows.begin(), rows.end(),
+                                       [&](const Row &r) { return std::strcmp(r.name, e.name) == 0; });
+                if (it == rows.end()) {
+                    rows.push_back({ e.name, e.begin });
+                    it = rows.end() - 1;
+                }
+                const uint64_t duration = e.end - e.begin;
+                it->first = std::min(it->first, e.begin);
+                it->count += 1;
+                it->total += duration;
+                it->max = std::max(it->max, duration);
+                wallBegin = std::min(wallBegin, e.begin);
+                wallEnd = std::max(wallEnd, e.end);
+            }
+        }
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.first < b.first; });
+
+    const double wall = wallEnd > wallBegin ? (double)(wallEnd - wallBegin) : 1.0;
+    std::string table;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-20s %10s %12s %12s %12s %8s\n", "Stage", "Count", "Total [ms]", "Mean [ms]",
+                  "Max [ms]", "Share");
+    table += line;
+    for (const Row &r : rows) {
+        std::snprintf(line, sizeof(line), "%-20s %10llu %12.3f %12.3f %12.3f %7.1f%%\n", r.name,
+                      (unsigned long long)r.count, r.total * 1.0e-6, r.total * 1.0e-6 / r.count, r.max * 1.0e-6,
+                      100.0 * r.total / wall);
+        table += line;
+    }
+    std::snprintf(line, sizeof(line), "%-20s %10s %12.3f\n", "Wall time", "", wall * 1.0e-6);
+    table += line;
+    return table;
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto &buffer : registry) {
+        buffer->events.clear();
+    }
+}
@@ -0,0 +1,83 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_TRACE_H
+#define LIBCBCT_TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+#include "Common/Api.h"
+
+/**
+ * @brief Process-wide recorder of timed spans
+ * @details Spans are appended to a buffer owned by the recording thread, so that recording takes no lock. While
+ * tracing is disabled (the default), a span costs a relaxed atomic load, and defining LIBCBCT_DISABLE_TRACE
+ * removes the spans altogether. The events are read by writeChromeTrace() and summary(), which must not run
+ * concurrently with traced code.
+ */
+class LIBCBCT_API Tracer {
+public:
+    static void enable(bool on = true);
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    //! Nanoseconds since the tracer was first used
+    static uint64_t now();
+
+    //! Record a span of the calling thread. The name must outlive the tracer (e.g., a string literal).
+    static void record(const char *name, uint64_t beginNs, uint64_t endNs);
+
+    //! Write all the spans in the Chrome trace-event format (chrome://tracing, Perfetto)
+    static void writeChromeTrace(const std::string &filename);
+
+    /**
+     * @brief Table of the count, total, mean and max duration of the spans with each name
+     * @details The rows are ordered by the first occurrence. The share is the total over the wall time from the
+     * first to the last span, which exceeds 100% for the spans running in parallel threads.
+     */
+    static std::string summary();
+
+    //! Drop all the recorded spans
+    static void clear();
+
+private:
+    static std::atomic<bool> active;
+};
+
+//! Span from the construction to the destruction, recorded only when tracing is enabled
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : name{ Tracer::enabled() ? name : nullptr }
+        , begin{ this->name ? Tracer::now() : 0 } {
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    ~TraceScope() {
+        if (name) {
+            Tracer::record(name, begin, Tracer::now());
+        }
+    }
+
+private:
+    const char *name;
+    uint64_t begin;
+};
+
+#define LIBCBCT_TRACE_CONCAT_(A, B) A##B
+#define LIBCBCT_TRACE_CONCAT(A, B) LIBCBCT_TRACE_CONCAT_(A, B)
+
+#if !defined(LIBCBCT_DISABLE_TRACE)
+#define LIBCBCT_TRACE_SCOPE(NAME) TraceScope LIBCBCT_TRACE_CONCAT(traceScope_, __LINE__)(NAME)
+#else
+#define LIBCBCT_TRACE_SCOPE(NAME)
+#endif
+
+#endif  // LIBCBCT_TRACE_H
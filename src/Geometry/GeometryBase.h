@@ -28,9 +28,8 @@ struct LIBCBCT_API Geometry {
     float sdd;
 };
 
-__both__ inline vec3f project(const vec3f &xyz, float theta, const Geometry& geom) {
-    const float cosTheta = cosf(theta);
-    const float sinTheta = sinf(theta);
+//! Same as project() below, but with the cosine and sine of the rotation angle given
+__both__ inline vec3f project(const vec3f &xyz, float cosTheta, float sinTheta, const Geometry &geom) {
     const float vx = xyz.x * cosTheta - xyz.y * sinTheta + geom.sod;
     const float vy = xyz.x * sinTheta + xyz.y * cosTheta;
     const float vz = xyz.z;
@@ -42,13 +41,20 @@ __both__ inline vec3f project(const vec3f &xyz, float theta, const Geometry& geo
     return vec3f(detUV.x, detUV.y, w);
 }
 
+__both__ inline vec3f project(const vec3f &xyz, float theta, const Geometry& geom) {
+    return project(xyz, cosf(theta), sinf(theta), geom);
+}
+
+//! Edge length of a voxel, with which the volume covers the detector width magnified at the rotation center
+__both__ inline float voxelSize(const Geometry &geom) {
+    return (geom.detSize.x * geom.pixSize.x) * (geom.sod / geom.sdd) / geom.volSize.x;
+}
+
 __both__ inline vec3f vox2pix(const vec3i &xyz, float theta, const Geometry &geom) {
     const float cx = geom.volSize.x * 0.5f;
     const float cy = geom.volSize.y * 0.5f;
     const float cz = geom.volSize.z * 0.5f;
-    const float voxelSize = (geom.detSize.x * geom.pixSize.x) * (geom.sod / geom.sdd) / geom.volSize.x;
-
-    const vec3f v = (vec3f(xyz) - vec3f(cx, cy, cz)) * voxelSize;
+    const vec3f v = (vec3f(xyz) - vec3f(cx, cy, cz)) * voxelSize(geom);
     return project(v, theta, geom);
 }
 
@@ -0,0 +1,159 @@
+#define LIBCBCT_API_EXPORT
+#include "AsyncFileWriter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
+
+AsyncFileWriter::AsyncFileWriter(const std::string &filename, uint64_t bufferSize, int numBuffers, bool directIO)
+    : filename{ filename }
+    , bufSize{ (bufferSize + kAlignment - 1) / kAlignment * kAlignment }
+    , directIO{ directIO } {
+    LIBCBCT_ASSERT(numBuffers >= 1, "At least one buffer is required!");
+
+#if defined(_WIN32)
+    file = std::fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+#else
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if defined(O_DIRECT)
+    if (directIO) {
+        flags |= O_DIRECT;
+    }
+#endif
+    fd = ::open(filename.c_str(), flags, 0644);
+    if (fd < 0 && directIO) {
+        // Some file systems (e.g., tmpfs) reject O_DIRECT
+        LIBCBCT_WARN("Direct I/O is not available for %s, falling back to buffered I/O", filename.c_str());
+        this->directIO = false;
+        fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (fd < 0) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+#if defined(__APPLE__)
+    if (directIO) {
+        fcntl(fd, F_NOCACHE, 1);
+    }
+#endif
+#endif
+
+    MemoryTracker::allocate(MemoryCategory::IO, bufSize * numBuffers);
+    for (int i = 0; i < numBuffers; i++) {
+        char *buffer = static_cast<char *>(::operator new[](bufSize, std::align_val_t(kAlignment)));
+        buffers.push_back(buffer);
+        freeBuffers.push_back(buffer);
+    }
+
+    writer = std::thread([this] { run(); });
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+    for (char *buffer : buffers) {
+        ::operator delete[](buffer, std::align_val_t(kAlignment));
+    }
+    MemoryTracker::release(MemoryCategory::IO, bufSize * buffers.size());
+}
+
+char *AsyncFileWriter::acquire() {
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [this] { return !freeBuffers.empty(); });
+    char *buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+void AsyncFileWriter::submit(char *buffer, uint64_t size) {
+    LIBCBCT_ASSERT(size <= bufSize, "Submitted size exceeds the buffer size!");
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        jobs.push_back({ buffer, nextOffset, size });
+        nextOffset += size;
+    }
+    cond.notify_all();
+}
+
+void AsyncFileWriter::close() {
+    if (closed) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        finishing = true;
+    }
+    cond.notify_all();
+    writer.join();
+
+#if defined(_WIN32)
+    std::fclose(static_cast<std::FILE *>(file));
+#else
+    // Direct writes are padded to the alignment, so the padding after the last voxel is cut off here
+    if (directIO && ::ftruncate(fd, (off_t)nextOffset) != 0) {
+        LIBCBCT_ERROR("Failed to truncate file: %s", filename.c_str());
+    }
+    ::close(fd);
+#endif
+    closed = true;
+}
+
+void AsyncFileWriter::run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cond.wait(lock, [this] { return finishing || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        writeAt(job.buffer, job.offset, job.size);
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            freeBuffers.push_back(job.buffer);
+        }
+        cond.notify_all();
+    }
+}
+
+void AsyncFileWriter::writeAt(const char *buffer, uint64_t offset, uint64_t size) {
+#if defined(_WIN32)
+    std::FILE *fp = static_cast<std::FILE *>(file);
+    if (_fseeki64(fp, (int64_t)offset, SEEK_SET) != 0 || std::fwrite(buffer, 1, size, fp) != size) {
+        LIBCBCT_ERROR("Failed to write file: %s", filename.c_str());
+    }
+#else
+    if (directIO) {
+        LIBCBCT_ASSERT(offset % kAlignment == 0, "Direct I/O requires aligned offsets!");
+        const uint64_t padded = (size + kAlignment - 1) / kAlignment * kAlignment;
+        std::memset(const_cast<char *>(buffer) + size, 0, padded - size);
+        size = padded;
+    }
+
+    uint64_t written = 0;
+    while (written < size) {
+        const ssize_t ret = ::pwrite(fd, buffer + written, size - written, (off_t)(offset + written));
+        if (ret <= 0) {
+            LIBCBCT_ERROR("Failed to write file: %s", filename.c_str());
+        }
+        written += (uint64_t)ret;
+    }
+#endif
+}
@@ -0,0 +1,75 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_ASYNC_FILE_WRITER_H
+#define LIBCBCT_ASYNC_FILE_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Common/Api.h"
+
+/**
+ * @brief Sequential file writer streaming a pool of buffers from a background thread
+ * @details The producer acquires a free buffer, fills it and submits it. Submitted buffers are written in order
+ * at increasing offsets by a writer thread with pwrite, and returned to the pool afterwards, so that filling the
+ * next buffer overlaps with the disk I/O. The buffers are aligned to kAlignment bytes, and with direct I/O
+ * (O_DIRECT on Linux) the page cache is bypassed. In that case all but the last submitted sizes must be multiples
+ * of kAlignment.
+ */
+class LIBCBCT_API AsyncFileWriter {
+public:
+    static constexpr uint64_t kAlignment = 4096;
+
+    AsyncFileWriter(const std::string &filename, uint64_t bufferSize, int numBuffers = 3, bool directIO = false);
+    AsyncFileWriter(const AsyncFileWriter &) = delete;
+    AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+    virtual ~AsyncFileWriter();
+
+    //! Take a free buffer of bufferSize() bytes, waiting until one is returned by the writer thread
+    char *acquire();
+
+    //! Queue the first "size" bytes of an acquired buffer to be written after the previously submitted ones
+    void submit(char *buffer, uint64_t size);
+
+    //! Wait for all the submitted buffers to be written and close the file
+    void close();
+
+    uint64_t bufferSize() const {
+        return bufSize;
+    }
+
+private:
+    struct Job {
+        char *buffer;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    void run();
+    void writeAt(const char *buffer, uint64_t offset, uint64_t size);
+
+    std::string filename;
+    uint64_t bufSize;
+    bool directIO;
+    int fd = -1;
+    void *file = nullptr;
+    uint64_t nextOffset = 0;
+    bool closed = false;
+
+    std::vector<char *> buffers;
+    std::vector<char *> freeBuffers;
+    std::deque<Job> jobs;
+    bool finishing = false;
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::thread writer;
+};
+
+#endif  // LIBCBCT_ASYNC_FILE_WRITER_H
@@ -0,0 +1,131 @@
+#define LIBCBCT_API_EXPORT
+#include "ChunkedVolumeExporter.h"
+
+#include <fstream>
+#include <vector>
+
+#if defined(LIBCBCT_WITH_ZLIB)
+#include <zlib.h>
+#endif  // LIBCBCT_WITH_ZLIB
+
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+#include "Common/MemoryTracker.h"
+#include "Common/PerfCounters.h"
+#include "Common/Trace.h"
+#include "ChunkedVolumeFormat.h"
+
+void ChunkedVolumeExporter::write(const std::string &filename, const VolumeF32 &tomogram, VolumeType type) const {
+    switch (type) {
+    case VolumeType::Uint8:
+        writeAsType<uint8_t>(filename, tomogram, true, 0.0f, 255.0f);
+        break;
+    case VolumeType::Uint16:
+        writeAsType<uint16_t>(filename, tomogram, true, 0.0f, 50000.0f);
+        break;
+    case VolumeType::Uint32:
+        writeAsType<uint32_t>(filename, tomogram, true, 0.0f, 50000.0f);
+        break;
+    case VolumeType::Float32:
+        writeAsType<float>(filename, tomogram, false);
+        break;
+    case VolumeType::Float64:
+        writeAsType<double>(filename, tomogram, false);
+        break;
+    default:
+        LIBCBCT_ERROR("Unsupported volume type for chunked export!");
+        break;
+    }
+}
+
+template <typename T>
+void ChunkedVolumeExporter::writeAsType(const std::string &filename, const VolumeF32 &tomogram, bool normalize,
+                                        float outMin, float outMax) const {
+    LIBCBCT_TRACE_SCOPE("export");
+    LIBCBCT_PERF_REGION("export", 0);
+    LIBCBCT_MEMORY_STAGE("export");
+#if defined(LIBCBCT_WITH_ZLIB)
+    std::ofstream writer(filename.c_str(), std::ios::out | std::ios::binary);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+
+    ChunkedVolumeHeader header;
+    header.type = Volume<T>().type();
+    header.size[0] = tomogram.size<0>();
+    header.size[1] = tomogram.size<1>();
+    header.size[2] = tomogram.size<2>();
+    header.voxelSize = voxelSize;
+    header.chunkSize = chunkSize;
+    header.compression = ChunkedVolumeHeader::Compression::Zlib;
+    header.chunks.resize(header.numChunks());
+
+    // Reserve the space for the header, which is written after the chunk offsets are known
+    std::vector<char> zeros(header.headerBytes(), 0);
+    writer.write(zeros.data(), zeros.size());
+
+    float minVal = 0.0f, maxVal = 1.0f;
+    if (normalize) {
+        std::tie(minVal, maxVal) = tomogram.getMinMax();
+    }
+
+    const int nChunks = header.numChunks();
+    const int batchSize = 4 * omp_get_max_threads();
+    std::vector<std::vector<Bytef>> compressed(batchSize);
+    const uLong chunkBytes = (uLong)chunkSize * chunkSize * chunkSize * sizeof(T);
+    const MemoryReservation batchBytes(MemoryCategory::IO,
+                                       (uint64_t)batchSize * (chunkBytes + compressBound(chunkBytes)));
+    uint64_t offset = header.headerBytes();
+    for (int batchStart = 0; batchStart < nChunks; batchStart += batchSize) {
+        const int batchEnd = std::min(nChunks, batchStart + batchSize);
+        OMP_PARALLEL_FOR(int c = batchStart; c < batchEnd; c++) {
+            uint64_t x0, x1, y0, y1, z0, z1;
+            header.chunkRange(c, 0, x0, x1);
+            header.chunkRange(c, 1, y0, y1);
+            header.chunkRange(c, 2, z0, z1);
+
+            std::vector<T> values((x1 - x0) * (y1 - y0) * (z1 - z0));
+            uint64_t i = 0;
+            for (uint64_t z = z0; z < z1; z++) {
+                for (uint64_t y = y0; y < y1; y++) {
+                    const float *row = tomogram.ptr() + (z * header.size[1] + y) * header.size[0];
+                    for (uint64_t x = x0; x < x1; x++) {
+                        float value = row[x];
+                        if (normalize) {
+                            value = (value - minVal) / (maxVal - minVal);
+                            value = outMin + value * (outMax - outMin);
+                        }
+                        values[i++] = static_cast<T>(value);
+                    }
+                }
+            }
+
+            const uLong srcBytes = (uLong)(values.size() * sizeof(T));
+            uLongf dstBytes = compressBound(srcBytes);
+            std::vector<Bytef> &dst = compressed[c - batchStart];
+            dst.resize(dstBytes);
+            if (compress2(dst.data(), &dstBytes, reinterpret_cast<const Bytef *>(values.data()), srcBytes,
+                          compressionLevel) != Z_OK) {
+                LIBCBCT_ERROR("Failed to compress chunk #%d", c);
+            }
+            dst.resize(dstBytes);
+        }
+
+        for (int c = batchStart; c < batchEnd; c++) {
+            const std::vector<Bytef> &data = compressed[c - batchStart];
+            writer.write(reinterpret_cast<const char *>(data.data()), data.size());
+            header.chunks[c] = { offset, (uint64_t)data.size() };
+            offset += data.size();
+        }
+    }
+
+    writer.seekp(0);
+    header.write(writer);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to write file: %s", filename.c_str());
+    }
+    writer.close();
+#else
+    LIBCBCT_ERROR("LibCBCT is not compiled with ZLIB, so chunked volumes cannot be written!");
+#endif  // LIBCBCT_WITH_ZLIB
+}
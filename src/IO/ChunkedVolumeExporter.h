@@ -0,0 +1,40 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_CHUNKED_VOLUME_EXPORTER_H
+#define LIBCBCT_CHUNKED_VOLUME_EXPORTER_H
+
+#include "BaseExporter.h"
+#include "Utils/Vec.h"
+
+/**
+ * @brief Exporter for chunked volume files (see ChunkedVolumeFormat.h)
+ * @details The chunks are converted and compressed in parallel in batches, and written in order. Integer volume
+ * types are normalized in the same way as RawVolumeExporter.
+ */
+class LIBCBCT_API ChunkedVolumeExporter : public BaseExporter {
+public:
+    explicit ChunkedVolumeExporter(int chunkSize = 64, const vec3f &voxelSize = vec3f(1.0f, 1.0f, 1.0f),
+                                   int compressionLevel = 1)
+        : BaseExporter{}
+        , chunkSize{ chunkSize }
+        , voxelSize{ voxelSize }
+        , compressionLevel{ compressionLevel } {
+    }
+    virtual ~ChunkedVolumeExporter() = default;
+
+    void write(const std::string &filename, const VolumeF32 &tomogram,
+               VolumeType type = VolumeType::Float32) const override;
+
+private:
+    template <typename T>
+    void writeAsType(const std::string &filename, const VolumeF32 &tomogram, bool normalize = false,
+                     float outMin = 0.0f, float outMax = 1.0f) const;
+
+    int chunkSize;
+    vec3f voxelSize;
+    int compressionLevel;
+};
+
+#endif  // LIBCBCT_CHUNKED_VOLUME_EXPORTER_H
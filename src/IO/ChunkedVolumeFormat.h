@@ -0,0 +1,145 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_CHUNKED_VOLUME_FORMAT_H
+#define LIBCBCT_CHUNKED_VOLUME_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "Common/Logging.h"
+#include "Utils/Vec.h"
+#include "Utils/Volume.h"
+
+// -----------------------------------------------------------------------------
+// Chunked volume file (*.cbv)
+// -----------------------------------------------------------------------------
+// The volume is split into cubic chunks, and each chunk is compressed independently with zlib, or stored as is
+// without compression. All the fields are stored in little endian.
+//
+//     char[8]    magic ("CBCTCHNK")
+//     uint32     version
+//     uint32     voxel type (VolumeType)
+//     uint64[3]  volume size
+//     float[3]   voxel size
+//     uint32     chunk size (edge length in voxels)
+//     uint32     compression (0: none, 1: zlib)
+//     uint64     number of chunks
+//     {uint64 offset, uint64 bytes}[number of chunks]
+//     chunk data ...
+//
+// The chunks are indexed x-fastest over the chunk grid. Each chunk holds the voxels inside the volume in x-fastest
+// order, so that the chunks at the upper boundaries are smaller than the others.
+// -----------------------------------------------------------------------------
+
+struct ChunkedVolumeHeader {
+    static constexpr char kMagic[8] = { 'C', 'B', 'C', 'T', 'C', 'H', 'N', 'K' };
+    static constexpr uint32_t kVersion = 1;
+
+    enum class Compression : uint32_t {
+        None = 0,
+        Zlib = 1,
+    };
+
+    struct ChunkEntry {
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    VolumeType type = VolumeType::Float32;
+    uint64_t size[3] = { 0, 0, 0 };
+    vec3f voxelSize = vec3f(1.0f, 1.0f, 1.0f);
+    uint32_t chunkSize = 64;
+    Compression compression = Compression::Zlib;
+    std::vector<ChunkEntry> chunks;
+
+    int chunkCount(int dim) const {
+        return (int)((size[dim] + chunkSize - 1) / chunkSize);
+    }
+
+    int numChunks() const {
+        return chunkCount(0) * chunkCount(1) * chunkCount(2);
+    }
+
+    //! Voxel range [begin, end) covered by the chunk along the given axis
+    void chunkRange(int chunk, int dim, uint64_t &begin, uint64_t &end) const {
+        int c = chunk;
+        for (int d = 0; d < dim; d++) {
+            c /= chunkCount(d);
+        }
+        c %= chunkCount(dim);
+        begin = (uint64_t)c * chunkSize;
+        end = std::min(size[dim], begin + chunkSize);
+    }
+
+    //! Number of bytes occupied by the header and the chunk table
+    uint64_t headerBytes() const {
+        return 8 + 4 + 4 + 3 * 8 + 3 * 4 + 4 + 4 + 8 + (uint64_t)numChunks() * 16;
+    }
+
+    void write(std::ostream &os) const {
+        const uint32_t version = kVersion;
+        const uint32_t typeId = (uint32_t)type;
+        const uint32_t compressionId = (uint32_t)compression;
+        const uint64_t nChunks = chunks.size();
+        os.write(kMagic, 8);
+        os.write(reinterpret_cast<const char *>(&version), 4);
+        os.write(reinterpret_cast<const char *>(&typeId), 4);
+        os.write(reinterpret_cast<const char *>(size), 3 * 8);
+        os.write(reinterpret_cast<const char *>(&voxelSize.x), 4);
+        os.write(reinterpret_cast<const char *>(&voxelSize.y), 4);
+        os.write(reinterpret_cast<const char *>(&voxelSize.z), 4);
+        os.write(reinterpret_cast<const char *>(&chunkSize), 4);
+        os.write(reinterpret_cast<const char *>(&compressionId), 4);
+        os.write(reinterpret_cast<const char *>(&nChunks), 8);
+        os.write(reinterpret_cast<const char *>(chunks.data()), nChunks * sizeof(ChunkEntry));
+    }
+
+    void read(std::istream &is) {
+        char magic[8];
+        uint32_t version, typeId, compressionId;
+        uint64_t nChunks;
+        is.read(magic, 8);
+        if (is.fail() || std::memcmp(magic, kMagic, 8) != 0) {
+            LIBCBCT_ERROR("Not a chunked volume file!");
+        }
+        is.read(reinterpret_cast<char *>(&version), 4);
+        if (version != kVersion) {
+            LIBCBCT_ERROR("Unsupported chunked volume version: %u", version);
+        }
+        is.read(reinterpret_cast<char *>(&typeId), 4);
+        is.read(reinterpret_cast<char *>(size), 3 * 8);
+        is.read(reinterpret_cast<char *>(&voxelSize.x), 4);
+        is.read(reinterpret_cast<char *>(&voxelSize.y), 4);
+        is.read(reinterpret_cast<char *>(&voxelSize.z), 4);
+        is.read(reinterpret_cast<char *>(&chunkSize), 4);
+        is.read(reinterpret_cast<char *>(&compressionId), 4);
+        is.read(reinterpret_cast<char *>(&nChunks), 8);
+        if (is.fail()) {
+            LIBCBCT_ERROR("Broken chunked volume header!");
+        }
+        if (typeId > (uint32_t)VolumeType::Float64) {
+            LIBCBCT_ERROR("Unsupported voxel type of chunked volume: %u", typeId);
+        }
+        if (compressionId > (uint32_t)Compression::Zlib) {
+            LIBCBCT_ERROR("Unsupported chunk compression: %u", compressionId);
+        }
+        type = (VolumeType)typeId;
+        compression = (Compression)compressionId;
+
+        if (chunkSize == 0 || nChunks != (uint64_t)numChunks()) {
+            LIBCBCT_ERROR("Broken chunked volume header!");
+        }
+        chunks.resize(nChunks);
+        is.read(reinterpret_cast<char *>(chunks.data()), nChunks * sizeof(ChunkEntry));
+        if (is.fail()) {
+            LIBCBCT_ERROR("Broken chunk table!");
+        }
+    }
+};
+
+#endif  // LIBCBCT_CHUNKED_VOLUME_FORMAT_H
@@ -0,0 +1,181 @@
+#define LIBCBCT_API_EXPORT
+#include "ChunkedVolumeImporter.h"
+
+#include <fstream>
+#include <vector>
+
+#if defined(LIBCBCT_WITH_ZLIB)
+#include <zlib.h>
+#endif  // LIBCBCT_WITH_ZLIB
+
+#include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
+#include "Common/OpenMP.h"
+
+namespace {
+
+template <typename T>
+void copyChunk(const char *src, const uint64_t chunkBegin[3], const uint64_t chunkEnd[3], const vec3i &origin,
+               const vec3i &size, float *out) {
+    const T *values = reinterpret_cast<const T *>(src);
+    const uint64_t nx = chunkEnd[0] - chunkBegin[0];
+    const uint64_t ny = chunkEnd[1] - chunkBegin[1];
+    const int64_t sx = size.x;
+    const int64_t sy = size.y;
+    const int64_t sz = size.z;
+
+    for (uint64_t z = chunkBegin[2]; z < chunkEnd[2]; z++) {
+        const int64_t rz = (int64_t)z - origin.z;
+        if (rz < 0 || rz >= sz) {
+            continue;
+        }
+        for (uint64_t y = chunkBegin[1]; y < chunkEnd[1]; y++) {
+            const int64_t ry = (int64_t)y - origin.y;
+            if (ry < 0 || ry >= sy) {
+                continue;
+            }
+            const T *row = values + ((z - chunkBegin[2]) * ny + (y - chunkBegin[1])) * nx;
+            float *dst = out + (rz * sy + ry) * sx;
+            for (uint64_t x = chunkBegin[0]; x < chunkEnd[0]; x++) {
+                const int64_t rx = (int64_t)x - origin.x;
+                if (rx >= 0 && rx < sx) {
+                    dst[rx] = (float)row[x - chunkBegin[0]];
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+ChunkedVolumeImporter::ChunkedVolumeImporter(const std::string &filename)
+    : BaseImporter{}
+    , filename{ filename } {
+    std::ifstream reader(filename.c_str(), std::ios::in | std::ios::binary);
+    if (reader.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    header.read(reader);
+}
+
+VolumeF32 ChunkedVolumeImporter::read() const {
+    return readRegion(vec3i(0, 0, 0), vec3i((int)header.size[0], (int)header.size[1], (int)header.size[2]));
+}
+
+VolumeF32 ChunkedVolumeImporter::readSlice(int axis, int index) const {
+    LIBCBCT_ASSERT(axis >= 0 && axis <= 2, "Slice axis must be 0, 1 or 2!");
+    vec3i origin(0, 0, 0);
+    vec3i size((int)header.size[0], (int)header.size[1], (int)header.size[2]);
+    origin[axis] = index;
+    size[axis] = 1;
+    return readRegion(origin, size);
+}
+
+VolumeF32 ChunkedVolumeImporter::readRegion(const vec3i &origin, const vec3i &size) const {
+    LIBCBCT_ASSERT(origin.x >= 0 && origin.y >= 0 && origin.z >= 0, "Region is out of the volume!");
+    LIBCBCT_ASSERT((uint64_t)(origin.x + size.x) <= header.size[0] &&
+                       (uint64_t)(origin.y + size.y) <= header.size[1] &&
+                       (uint64_t)(origin.z + size.z) <= header.size[2],
+                   "Region is out of the volume!");
+
+#if !defined(LIBCBCT_WITH_ZLIB)
+    if (header.compression == ChunkedVolumeHeader::Compression::Zlib) {
+        LIBCBCT_ERROR("LibCBCT is not compiled with ZLIB, so compressed chunked volumes cannot be read!");
+    }
+#endif  // LIBCBCT_WITH_ZLIB
+
+    // List the chunks overlapping the region
+    std::vector<int> chunkIds;
+    const int cs = (int)header.chunkSize;
+    for (int cz = origin.z / cs; cz <= (origin.z + size.z - 1) / cs; cz++) {
+        for (int cy = origin.y / cs; cy <= (origin.y + size.y - 1) / cs; cy++) {
+            for (int cx = origin.x / cs; cx <= (origin.x + size.x - 1) / cs; cx++) {
+                chunkIds.push_back((cz * header.chunkCount(1) + cy) * header.chunkCount(0) + cx);
+            }
+        }
+    }
+
+    // Read the stored chunks sequentially, and decompress them in parallel
+    std::ifstream reader(filename.c_str(), std::ios::in | std::ios::binary);
+    if (reader.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+
+    std::vector<std::vector<char>> compressed(chunkIds.size());
+    uint64_t compressedBytes = 0;
+    for (size_t i = 0; i < chunkIds.size(); i++) {
+        compressedBytes += header.chunks[chunkIds[i]].bytes;
+    }
+    const uint64_t chunkBytes = header.compression == ChunkedVolumeHeader::Compression::Zlib
+                                    ? (uint64_t)cs * cs * cs * volumeTypeSize(header.type)
+                                    : 0;
+    const MemoryReservation bufferBytes(MemoryCategory::IO, compressedBytes + omp_get_max_threads() * chunkBytes);
+    for (size_t i = 0; i < chunkIds.size(); i++) {
+        const auto &entry = header.chunks[chunkIds[i]];
+        compressed[i].resize(entry.bytes);
+        reader.seekg((std::streamoff)entry.offset);
+        reader.read(compressed[i].data(), entry.bytes);
+        if (reader.fail()) {
+            LIBCBCT_ERROR("Failed to read chunk #%d", chunkIds[i]);
+        }
+    }
+
+    VolumeF32 region(size.x, size.y, size.z);
+    float *const out = region.ptr();
+    const size_t typeSize = volumeTypeSize(header.type);
+    OMP_PARALLEL_FOR(int i = 0; i < (int)chunkIds.size(); i++) {
+        uint64_t begin[3], end[3];
+        for (int d = 0; d < 3; d++) {
+            header.chunkRange(chunkIds[i], d, begin[d], end[d]);
+        }
+
+        const uint64_t bytes = (end[0] - begin[0]) * (end[1] - begin[1]) * (end[2] - begin[2]) * typeSize;
+        const char *values = compressed[i].data();
+        std::vector<char> decompressed;
+        switch (header.compression) {
+        case ChunkedVolumeHeader::Compression::None:
+            // Uncompressed chunks are converted from the read buffer
+            if (compressed[i].size() != bytes) {
+                LIBCBCT_ERROR("Broken chunk #%d", chunkIds[i]);
+            }
+            break;
+        case ChunkedVolumeHeader::Compression::Zlib: {
+#if defined(LIBCBCT_WITH_ZLIB)
+            decompressed.resize(bytes);
+            uLongf decompressedBytes = (uLongf)bytes;
+            if (uncompress(reinterpret_cast<Bytef *>(decompressed.data()), &decompressedBytes,
+                           reinterpret_cast<const Bytef *>(compressed[i].data()),
+                           (uLong)compressed[i].size()) != Z_OK ||
+                decompressedBytes != bytes) {
+                LIBCBCT_ERROR("Failed to decompress chunk #%d", chunkIds[i]);
+            }
+            values = decompressed.data();
+#endif  // LIBCBCT_WITH_ZLIB
+            break;
+        }
+        }
+
+        switch (header.type) {
+        case VolumeType::Uint8:
+            copyChunk<uint8_t>(values, begin, end, origin, size, out);
+            break;
+        case VolumeType::Uint16:
+            copyChunk<uint16_t>(values, begin, end, origin, size, out);
+            break;
+        case VolumeType::Uint32:
+            copyChunk<uint32_t>(values, begin, end, origin, size, out);
+            break;
+        case VolumeType::Float32:
+            copyChunk<float>(values, begin, end, origin, size, out);
+            break;
+        case VolumeType::Float64:
+            copyChunk<double>(values, begin, end, origin, size, out);
+            break;
+        default:
+            LIBCBCT_ERROR("Unsupported volume type for chunked import!");
+            break;
+        }
+    }
+
+    return region;
+}
@@ -0,0 +1,49 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_CHUNKED_VOLUME_IMPORTER_H
+#define LIBCBCT_CHUNKED_VOLUME_IMPORTER_H
+
+#include "BaseImporter.h"
+#include "ChunkedVolumeFormat.h"
+
+/**
+ * @brief Importer for chunked volume files (see ChunkedVolumeFormat.h)
+ * @details Only the header and the chunk table are read on construction. A slice or a region of interest is
+ * read by decompressing only the chunks it touches, in parallel. Uncompressed chunks are converted as read, which
+ * does not need zlib. The voxel values are converted to float as stored, i.e., without undoing the normalization
+ * of integer types.
+ */
+class LIBCBCT_API ChunkedVolumeImporter : public BaseImporter {
+public:
+    explicit ChunkedVolumeImporter(const std::string &filename);
+    virtual ~ChunkedVolumeImporter() = default;
+
+    VolumeF32 read() const override;
+
+    //! Read the region of the given origin and size
+    VolumeF32 readRegion(const vec3i &origin, const vec3i &size) const;
+
+    //! Read a single slice perpendicular to the given axis as a volume of thickness one
+    VolumeF32 readSlice(int axis, int index) const;
+
+    template <int Dim>
+    typename std::enable_if<Dim >= 0 && Dim <= 2, uint64_t>::type size() const {
+        return header.size[Dim];
+    }
+
+    VolumeType type() const {
+        return header.type;
+    }
+
+    vec3f voxelSize() const {
+        return header.voxelSize;
+    }
+
+private:
+    std::string filename;
+    ChunkedVolumeHeader header;
+};
+
+#endif  // LIBCBCT_CHUNKED_VOLUME_IMPORTER_H
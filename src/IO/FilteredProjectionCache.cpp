@@ -0,0 +1,96 @@
+#define LIBCBCT_API_EXPORT
+#include "FilteredProjectionCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "Common/Logging.h"
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+bool FilteredProjectionCache::load(uint64_t key, VolumeF32 &filtered) const {
+    if (!fs::exists(filename)) {
+        return false;
+    }
+
+    auto file = std::make_shared<MappedFile>(filename);
+    if (file->size() < kHeaderBytes) {
+        LIBCBCT_WARN("Broken filtered projection cache: %s", filename.c_str());
+        return false;
+    }
+
+    const char *header = file->data();
+    uint32_t version;
+    uint64_t storedKey, size[3];
+    std::memcpy(&version, header + 8, 4);
+    std::memcpy(&storedKey, header + 16, 8);
+    std::memcpy(size, header + 24, 3 * 8);
+    if (std::memcmp(header, kMagic, 8) != 0 || version != kVersion) {
+        LIBCBCT_WARN("Broken filtered projection cache: %s", filename.c_str());
+        return false;
+    }
+    if (storedKey != key) {
+        LIBCBCT_INFO("Filtered projection cache is outdated: %s", filename.c_str());
+        return false;
+    }
+    if (file->size() < kHeaderBytes + sizeof(float) * size[0] * size[1] * size[2]) {
+        LIBCBCT_WARN("Broken filtered projection cache: %s", filename.c_str());
+        return false;
+    }
+
+    float *voxels = reinterpret_cast<float *>(file->data() + kHeaderBytes);
+    filtered = VolumeF32::wrap(size[0], size[1], size[2], std::shared_ptr<float[]>(file, voxels));
+    return true;
+}
+
+void FilteredProjectionCache::store(uint64_t key, const VolumeF32 &filtered) const {
+    // Written to a temporary file first, so that an interrupted run never leaves a truncated cache behind
+    const std::string tempName = filename + ".tmp";
+    std::ofstream writer(tempName.c_str(), std::ios::out | std::ios::binary);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", tempName.c_str());
+    }
+
+    char header[kHeaderBytes] = {};
+    const uint32_t version = kVersion;
+    const uint64_t size[3] = { filtered.size<0>(), filtered.size<1>(), filtered.size<2>() };
+    std::memcpy(header, kMagic, 8);
+    std::memcpy(header + 8, &version, 4);
+    std::memcpy(header + 16, &key, 8);
+    std::memcpy(header + 24, size, 3 * 8);
+    writer.write(header, kHeaderBytes);
+    writer.write(reinterpret_cast<const char *>(filtered.ptr()), sizeof(float) * filtered.count());
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to write file: %s", tempName.c_str());
+    }
+    writer.close();
+
+    std::error_code ec;
+    fs::rename(tempName, filename, ec);
+    if (ec) {
+        LIBCBCT_ERROR("Failed to rename %s to %s", tempName.c_str(), filename.c_str());
+    }
+}
+
+void FilteredProjectionCache::hashFiles(Hasher &hasher, const std::string &folder, const std::string &extension) {
+    std::vector<fs::path> files;
+    for (const auto &entry : fs::directory_iterator(fs::path(folder))) {
+        if (!fs::is_directory(entry.path()) && entry.path().extension().string() == extension) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    // Hashing the file contents would cost as much as importing them, so the file metadata is used instead
+    hasher.add((uint64_t)files.size());
+    for (const auto &path : files) {
+        hasher.add(path.filename().string());
+        hasher.add((uint64_t)fs::file_size(path));
+        hasher.add((int64_t)fs::last_write_time(path).time_since_epoch().count());
+    }
+}
@@ -0,0 +1,50 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_FILTERED_PROJECTION_CACHE_H
+#define LIBCBCT_FILTERED_PROJECTION_CACHE_H
+
+#include <string>
+
+#include "Common/Api.h"
+#include "Common/Hash.h"
+#include "Utils/Volume.h"
+
+/**
+ * @brief On-disk cache of ramp-filtered projections
+ * @details The cache file holds a 64-byte header followed by the filtered projections as float. The header stores a
+ * key hashing everything the filtered projections depend on (input files, geometry, filter and preprocessing), and
+ * a cache with a different key is treated as missing. A cache hit memory-maps the file instead of reading it.
+ *
+ *     char[8]    magic ("CBCTFPRJ")
+ *     uint32     version
+ *     uint32     reserved
+ *     uint64     key
+ *     uint64[3]  size (detector width, detector height, number of projections)
+ *     padding up to 64 bytes
+ */
+class LIBCBCT_API FilteredProjectionCache {
+public:
+    explicit FilteredProjectionCache(const std::string &filename)
+        : filename{ filename } {
+    }
+
+    //! Map the cached projections if the cache exists with the given key
+    bool load(uint64_t key, VolumeF32 &filtered) const;
+
+    //! Write the projections with the given key, replacing the cache atomically
+    void store(uint64_t key, const VolumeF32 &filtered) const;
+
+    //! Add the names, sizes and modification times of the files with the extension in the folder to the hash
+    static void hashFiles(Hasher &hasher, const std::string &folder, const std::string &extension);
+
+private:
+    static constexpr char kMagic[8] = { 'C', 'B', 'C', 'T', 'F', 'P', 'R', 'J' };
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint64_t kHeaderBytes = 64;
+
+    std::string filename;
+};
+
+#endif  // LIBCBCT_FILTERED_PROJECTION_CACHE_H
@@ -7,32 +7,48 @@
 #include <opencv2/opencv.hpp>
 
 #include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
 #include "Common/OpenMP.h"
 #include "Common/ProgressBar.h"
+#include "Common/Trace.h"
 
 namespace fs = std::filesystem;
 
 VolumeF32 ImageSequenceImporter::read() const {
+    return readAs<float>();
+}
+
+VolumeU16 ImageSequenceImporter::readCounts() const {
+    return readAs<uint16_t>();
+}
+
+template <typename T>
+Volume<T> ImageSequenceImporter::readAs() const {
+    LIBCBCT_MEMORY_STAGE("import");
+
     // Get image file list
     std::vector<std::string> fileList;
-    const fs::path folderPath(folder.c_str());
-    for (const auto &entry : fs::directory_iterator(folderPath)) {
-        if (fs::is_directory(entry.path())) {
-            continue;
+    {
+        LIBCBCT_TRACE_SCOPE("scan");
+        const fs::path folderPath(folder.c_str());
+        for (const auto &entry : fs::directory_iterator(folderPath)) {
+            if (fs::is_directory(entry.path())) {
+                continue;
+            }
+
+            const std::string ext = entry.path().extension().string();
+            if (ext == extension) {
+                fileList.push_back(entry.path().string());
+            }
         }
 
-        const std::string ext = entry.path().extension().string();
-        if (ext == extension) {
-            fileList.push_back(entry.path().string());
+        if (fileList.empty()) {
+            LIBCBCT_ERROR("No image files found in folder: %s", folder.c_str());
         }
-    }
 
-    if (fileList.empty()) {
-        LIBCBCT_ERROR("No image files found in folder: %s", folder.c_str());
+        std::sort(fileList.begin(), fileList.end());
     }
 
-    std::sort(fileList.begin(), fileList.end());
-
     // Get image size
     cv::Mat firstImage = cv::imread(fileList[0], cv::IMREAD_UNCHANGED);
     if (firstImage.empty()) {
@@ -42,21 +58,26 @@ VolumeF32 ImageSequenceImporter::read() const {
     const int height = firstImage.rows;
     const int nImages = static_cast<int>(fileList.size());
 
-    // Load images into sinogram volume
-    VolumeF32 sinogram(width, height, nImages);
+    // Load images into sinogram volume, with an image decoded by each thread at a time
+    Volume<T> sinogram(width, height, nImages);
+    const MemoryReservation imageBytes(MemoryCategory::IO,
+                                       (uint64_t)omp_get_max_threads() * firstImage.total() * firstImage.elemSize());
 
     ProgressBar pbar(nImages);
     pbar.setDescription("IMPORT: ");
+    T *const out = sinogram.ptr();
     OMP_PARALLEL_FOR(int i = 0; i < nImages; i++) {
+        LIBCBCT_TRACE_SCOPE("decode");
         cv::Mat image = cv::imread(fileList[i], cv::IMREAD_UNCHANGED);
         if (image.empty()) {
             LIBCBCT_ERROR("failed to open image: %s", fileList[i].c_str());
         }
 
+        const int index = reverseOrder ? (nImages - 1 - i) : i;
+        T *const proj = out + (uint64_t)width * height * index;
         for (int y = 0; y < height; y++) {
             for (int x = 0; x < width; x++) {
-                const int index = reverseOrder ? (nImages - 1 - i) : i;
-                sinogram(x, y, index) = (float)image.at<uint16_t>(y, x);
+                proj[(uint64_t)y * width + x] = (T)image.at<uint16_t>(y, x);
             }
         }
         pbar.step();
@@ -19,7 +19,13 @@ public:
 
     VolumeF32 read() const override;
 
+    //! Read the 16-bit images as they are, which takes half the memory of read()
+    VolumeU16 readCounts() const;
+
 private:
+    template <typename T>
+    Volume<T> readAs() const;
+
     std::string folder;
     std::string extension;
     bool reverseOrder = false;
@@ -0,0 +1,79 @@
+#define LIBCBCT_API_EXPORT
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "Common/Logging.h"
+
+MappedFile::MappedFile(const std::string &filename)
+    : filename{ filename } {
+#if defined(_WIN32)
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(fileHandle, &size);
+    fileSize = (uint64_t)size.QuadPart;
+    if (fileSize == 0) {
+        return;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        LIBCBCT_ERROR("Failed to map file: %s", filename.c_str());
+    }
+    mapped = static_cast<char *>(MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0));
+#else
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        LIBCBCT_ERROR("Failed to get file size: %s", filename.c_str());
+    }
+    fileSize = (uint64_t)st.st_size;
+    if (fileSize == 0) {
+        ::close(fd);
+        return;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *ptr = ::mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    mapped = ptr == MAP_FAILED ? nullptr : static_cast<char *>(ptr);
+#endif
+    if (mapped == nullptr) {
+        LIBCBCT_ERROR("Failed to map file: %s", filename.c_str());
+    }
+}
+
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+    if (mapped != nullptr) {
+        UnmapViewOfFile(mapped);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr && fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (mapped != nullptr) {
+        ::munmap(mapped, fileSize);
+    }
+#endif
+}
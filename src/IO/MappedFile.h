@@ -0,0 +1,43 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_MAPPED_FILE_H
+#define LIBCBCT_MAPPED_FILE_H
+
+#include <cstdint>
+#include <string>
+
+#include "Common/Api.h"
+
+/**
+ * @brief Read-only file mapped into memory
+ * @details The file is mapped copy-on-write (MAP_PRIVATE on POSIX, FILE_MAP_COPY on Windows), so that the mapped
+ * pages can be modified in memory without changing the file. The pages are loaded from the disk on first access.
+ */
+class LIBCBCT_API MappedFile {
+public:
+    explicit MappedFile(const std::string &filename);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    virtual ~MappedFile();
+
+    char *data() const {
+        return mapped;
+    }
+
+    uint64_t size() const {
+        return fileSize;
+    }
+
+private:
+    std::string filename;
+    char *mapped = nullptr;
+    uint64_t fileSize = 0;
+#if defined(_WIN32)
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
+
+#endif  // LIBCBCT_MAPPED_FILE_H
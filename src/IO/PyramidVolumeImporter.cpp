@@ -0,0 +1,107 @@
+#define LIBCBCT_API_EXPORT
+#include "PyramidVolumeImporter.h"
+
+#include <fstream>
+#include <vector>
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include "Common/Logging.h"
+#include "RawVolumeExporter.h"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+template <typename T>
+void readRows(std::ifstream &reader, const vec3i &levelSize, const vec3i &origin, VolumeF32 &region) {
+    const int sx = region.size<0>();
+    std::vector<T> row(sx);
+    float *const out = region.ptr();
+    for (int z = 0; z < (int)region.size<2>(); z++) {
+        for (int y = 0; y < (int)region.size<1>(); y++) {
+            const uint64_t offset =
+                (((uint64_t)(origin.z + z) * levelSize.y + (origin.y + y)) * levelSize.x + origin.x) * sizeof(T);
+            reader.seekg((std::streamoff)offset);
+            reader.read(reinterpret_cast<char *>(row.data()), sizeof(T) * sx);
+            float *dst = out + ((uint64_t)z * region.size<1>() + y) * sx;
+            for (int x = 0; x < sx; x++) {
+                dst[x] = (float)row[x];
+            }
+        }
+    }
+}
+
+}  // namespace
+
+PyramidVolumeImporter::PyramidVolumeImporter(const std::string &filename)
+    : BaseImporter{} {
+    const std::string descriptorName =
+        fs::path(filename).extension() == ".json" ? filename : RawVolumeExporter::pyramidFilename(filename);
+    std::ifstream reader(descriptorName.c_str(), std::ios::in);
+    if (reader.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", descriptorName.c_str());
+    }
+
+    const json descriptor = json::parse(reader);
+    voxelType = volumeTypeFromName(descriptor.at("type").get<std::string>());
+    const fs::path folder = fs::path(descriptorName).parent_path();
+    for (const auto &level : descriptor.at("levels")) {
+        const auto &size = level.at("size");
+        levels.push_back({ (folder / level.at("file").get<std::string>()).string(),
+                           vec3i(size.at(0).get<int>(), size.at(1).get<int>(), size.at(2).get<int>()) });
+    }
+    if (levels.empty()) {
+        LIBCBCT_ERROR("No levels are found in the pyramid: %s", descriptorName.c_str());
+    }
+}
+
+VolumeF32 PyramidVolumeImporter::read() const {
+    return read(0);
+}
+
+VolumeF32 PyramidVolumeImporter::read(int level) const {
+    return readRegion(level, vec3i(0, 0, 0), levelSize(level));
+}
+
+VolumeF32 PyramidVolumeImporter::readRegion(int level, const vec3i &origin, const vec3i &size) const {
+    const Level &lv = levels.at(level);
+    LIBCBCT_ASSERT(origin.x >= 0 && origin.y >= 0 && origin.z >= 0 && size.x > 0 && size.y > 0 && size.z > 0 &&
+                       origin.x + size.x <= lv.size.x && origin.y + size.y <= lv.size.y &&
+                       origin.z + size.z <= lv.size.z,
+                   "Region is out of the volume!");
+
+    std::ifstream reader(lv.filename.c_str(), std::ios::in | std::ios::binary);
+    if (reader.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", lv.filename.c_str());
+    }
+
+    VolumeF32 region(size.x, size.y, size.z);
+    switch (voxelType) {
+    case VolumeType::Uint8:
+        readRows<uint8_t>(reader, lv.size, origin, region);
+        break;
+    case VolumeType::Uint16:
+        readRows<uint16_t>(reader, lv.size, origin, region);
+        break;
+    case VolumeType::Uint32:
+        readRows<uint32_t>(reader, lv.size, origin, region);
+        break;
+    case VolumeType::Float32:
+        readRows<float>(reader, lv.size, origin, region);
+        break;
+    case VolumeType::Float64:
+        readRows<double>(reader, lv.size, origin, region);
+        break;
+    default:
+        LIBCBCT_ERROR("Unsupported volume type for pyramid import!");
+        break;
+    }
+
+    if (reader.fail()) {
+        LIBCBCT_ERROR("Failed to read file: %s", lv.filename.c_str());
+    }
+    return region;
+}
@@ -0,0 +1,56 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_PYRAMID_VOLUME_IMPORTER_H
+#define LIBCBCT_PYRAMID_VOLUME_IMPORTER_H
+
+#include <vector>
+
+#include "BaseImporter.h"
+#include "Utils/Vec.h"
+
+/**
+ * @brief Importer for volume pyramids written by RawVolumeExporter
+ * @details Only the JSON descriptor is read on construction. A level or a region of interest is read directly from
+ * the raw file of the level, so that an overview of a large volume is loaded without touching the full-resolution
+ * file. The voxel values are converted to float as stored.
+ */
+class LIBCBCT_API PyramidVolumeImporter : public BaseImporter {
+public:
+    //! @param filename Either the pyramid descriptor or the full-resolution raw file
+    explicit PyramidVolumeImporter(const std::string &filename);
+    virtual ~PyramidVolumeImporter() = default;
+
+    //! Read the full-resolution volume
+    VolumeF32 read() const override;
+
+    //! Read the given level, where level 0 is the full resolution
+    VolumeF32 read(int level) const;
+
+    //! Read the region of the given origin and size, both in the voxels of the level
+    VolumeF32 readRegion(int level, const vec3i &origin, const vec3i &size) const;
+
+    int numLevels() const {
+        return (int)levels.size();
+    }
+
+    vec3i levelSize(int level) const {
+        return levels.at(level).size;
+    }
+
+    VolumeType type() const {
+        return voxelType;
+    }
+
+private:
+    struct Level {
+        std::string filename;
+        vec3i size;
+    };
+
+    VolumeType voxelType = VolumeType::Float32;
+    std::vector<Level> levels;
+};
+
+#endif  // LIBCBCT_PYRAMID_VOLUME_IMPORTER_H
@@ -3,6 +3,32 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include "Common/MemoryTracker.h"
+#include "Common/PerfCounters.h"
+#include "Common/Trace.h"
+
+namespace fs = std::filesystem;
+namespace expr = libcbct::expr;
+using json = nlohmann::json;
+
+namespace {
+
+void writeJson(const std::string &filename, const json &content) {
+    std::ofstream writer(filename.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
+    }
+    writer << content.dump(2) << std::endl;
+    writer.close();
+}
+
+}  // namespace
 
 void RawVolumeExporter::write(const std::string &filename, const VolumeF32 &tomogram, VolumeType type) const {
     switch (type) {
@@ -25,4 +51,99 @@ void RawVolumeExporter::write(const std::string &filename, const VolumeF32 &tomo
         LIBCBCT_ERROR("Unsupported volume type for RAW export!");
         break;
     }
-}
\ No newline at end of file
+}
+
+std::string RawVolumeExporter::levelFilename(const std::string &filename, int level) {
+    if (level == 0) {
+        return filename;
+    }
+    const fs::path path(filename);
+    return (path.parent_path() / (path.stem().string() + ".L" + std::to_string(level) + path.extension().string()))
+        .string();
+}
+
+std::string RawVolumeExporter::metadataFilename(const std::string &filename) {
+    return filename + ".json";
+}
+
+std::string RawVolumeExporter::pyramidFilename(const std::string &filename) {
+    const fs::path path(filename);
+    return (path.parent_path() / (path.stem().string() + ".pyramid.json")).string();
+}
+
+template <typename T>
+void RawVolumeExporter::writeAsType(const std::string &filename, const VolumeF32 &tomogram, bool normalize,
+                                    float outMin, float outMax) const {
+    LIBCBCT_TRACE_SCOPE("export");
+    LIBCBCT_PERF_REGION("export", 0);
+    LIBCBCT_MEMORY_STAGE("export");
+    float minVal = 0.0f, maxVal = 1.0f;
+    if (normalize) {
+        std::tie(minVal, maxVal) = tomogram.getMinMax();
+    }
+
+    // All the pyramid levels are quantized with the value range of the full-resolution volume
+    const auto writeLevel = [&](const std::string &name, const VolumeF32 &volume, auto &&onSlab) {
+        if (normalize) {
+            write(name, cast<T>(outMin + (volume - minVal) / (maxVal - minVal) * (outMax - outMin)), onSlab);
+        } else {
+            write(name, expr::cast<T>(volume), onSlab);
+        }
+
+        json metadata;
+        metadata["size"] = { volume.size<0>(), volume.size<1>(), volume.size<2>() };
+        metadata["type"] = volumeTypeName(Volume<T>().type());
+        writeJson(metadataFilename(name), metadata);
+    };
+
+    // Levels are added only while the previous level can be reduced
+    int numLevels = 0;
+    for (int s = std::max({ tomogram.size<0>(), tomogram.size<1>(), tomogram.size<2>() });
+         numLevels < pyramidLevels && s > 1; s = pyramidLevelSize(s)) {
+        numLevels++;
+    }
+
+    if (numLevels == 0) {
+        writeLevel(filename, tomogram, [](uint64_t, uint64_t) {});
+        return;
+    }
+
+    // The first reduced level is computed from the slices converted so far, while they are being written
+    const int sizeZ = tomogram.size<2>();
+    const uint64_t sliceSize = tomogram.size<0>() * tomogram.size<1>();
+    const int reach = pyramidFilterReach(pyramidFilter);
+    VolumeF32 level(pyramidLevelSize(tomogram.size<0>()), pyramidLevelSize(tomogram.size<1>()),
+                    pyramidLevelSize(sizeZ));
+    int nextZ = 0;
+    writeLevel(filename, tomogram, [&](uint64_t, uint64_t end) {
+        const int done = (int)(end / sliceSize);
+        int lastZ = nextZ;
+        while (lastZ < (int)level.size<2>() && std::min(2 * lastZ + reach - 1, sizeZ - 1) < done) {
+            lastZ++;
+        }
+        LIBCBCT_TRACE_SCOPE("pyramid");
+        downsample2x(tomogram, level, pyramidFilter, nextZ, lastZ);
+        nextZ = lastZ;
+    });
+
+    json levels = json::array();
+    levels.push_back({ { "file", fs::path(filename).filename().string() },
+                       { "size", { tomogram.size<0>(), tomogram.size<1>(), tomogram.size<2>() } } });
+    for (int l = 1; l <= numLevels; l++) {
+        const std::string name = levelFilename(filename, l);
+        writeLevel(name, level, [](uint64_t, uint64_t) {});
+        levels.push_back({ { "file", fs::path(name).filename().string() },
+                           { "size", { level.size<0>(), level.size<1>(), level.size<2>() } } });
+        if (l < numLevels) {
+            LIBCBCT_TRACE_SCOPE("pyramid");
+            level = downsample2x(level, pyramidFilter);
+        }
+    }
+
+    json descriptor;
+    descriptor["type"] = volumeTypeName(Volume<T>().type());
+    descriptor["filter"] = pyramidFilter == PyramidFilter::Box ? "box" : "gaussian";
+    descriptor["levels"] = levels;
+
+    writeJson(pyramidFilename(filename), descriptor);
+}
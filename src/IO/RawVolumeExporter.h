@@ -5,50 +5,99 @@
 #ifndef LIBCBCT_RAW_VOLUME_EXPORTER_H
 #define LIBCBCT_RAW_VOLUME_EXPORTER_H
 
-#include <iostream>
-#include <fstream>
+#include <algorithm>
 
 #include "BaseExporter.h"
+#include "AsyncFileWriter.h"
+#include "Utils/VolumeExpr.h"
+#include "Utils/VolumePyramid.h"
 
 class LIBCBCT_API RawVolumeExporter : public BaseExporter {
 public:
-    RawVolumeExporter() = default;
+    /**
+     * @details Along with each raw file written by write(filename, tomogram, type), a metadata sidecar named by
+     * metadataFilename() is written.
+     * @param directIO Bypass the page cache when writing the file
+     * @param pyramidLevels Number of additional levels reduced by a factor of two, written to the files named by
+     * levelFilename(), together with a JSON descriptor named by pyramidFilename()
+     * @param pyramidFilter Filter used to reduce the pyramid levels
+     */
+    explicit RawVolumeExporter(bool directIO = false, int pyramidLevels = 0,
+                               PyramidFilter pyramidFilter = PyramidFilter::Box)
+        : BaseExporter{}
+        , directIO{ directIO }
+        , pyramidLevels{ pyramidLevels }
+        , pyramidFilter{ pyramidFilter } {
+    }
     virtual ~RawVolumeExporter() = default;
 
     void write(const std::string &filename, const VolumeF32 &tomogram,
                VolumeType type = VolumeType::Float32) const override;
 
-private:
-    template <typename T>
-    void writeAsType(const std::string &filename, const VolumeF32 &tomogram, bool normalize = false,
-                     float outMin = 0.0f, float outMax = 1.0f) const {
-        std::ofstream writer(filename.c_str(), std::ios::out | std::ios::binary);
-        if (writer.fail()) {
-            LIBCBCT_ERROR("Failed to open file: %s", filename.c_str());
-        }
+    /**
+     * @brief Write the values of a voxel-wise expression as raw data of its value type
+     * @details The expression is evaluated slab by slab in parallel into a pool of buffers, which a background
+     * thread streams to the file, so that the conversion of a slab overlaps with writing the previous one and no
+     * intermediate volume is created.
+     */
+    template <typename E>
+    void write(const std::string &filename, const libcbct::expr::VolumeExpr<E> &expr) const {
+        write(filename, expr, [](uint64_t, uint64_t) {});
+    }
+
+    /**
+     * @brief Same as above, but calls onSlab(begin, end) after the voxels [begin, end) are converted
+     * @details The callback runs while the converted slab is being written, so that additional work on the same
+     * voxels (e.g., reducing them for the pyramid) overlaps with the disk I/O.
+     */
+    template <typename E, typename SlabFunc>
+    void write(const std::string &filename, const libcbct::expr::VolumeExpr<E> &expr, SlabFunc &&onSlab) const {
+        using T = typename E::value_type;
+        const uint64_t slabSize = slabBytes / sizeof(T);
+        const uint64_t total = expr.self().count();
 
-        const int sizeX = tomogram.size<0>();
-        const int sizeY = tomogram.size<1>();
-        const int sizeZ = tomogram.size<2>();
-        const auto [minVal, maxVal] = tomogram.getMinMax();
-
-        auto buffer = std::make_unique<T[]>(sizeX * sizeY);
-        for (int z = 0; z < sizeZ; z++) {
-            for (int y = 0; y < sizeY; y++) {
-                for (int x = 0; x < sizeX; x++) {
-                    float value = tomogram(x, y, z);
-                    if (normalize) {
-                        value = (value - minVal) / (maxVal - minVal);
-                        value = outMin + value * (outMax - outMin);
-                    }
-                    const T outValue = static_cast<T>(value);
-                    buffer[y * sizeX + x] = outValue;
-                }
-            }
-            writer.write(reinterpret_cast<char *>(buffer.get()), sizeof(T) * sizeX * sizeY);
+        AsyncFileWriter writer(filename, slabBytes, numBuffers, directIO);
+        for (uint64_t begin = 0; begin < total; begin += slabSize) {
+            const uint64_t end = std::min(total, begin + slabSize);
+            char *buffer = writer.acquire();
+            evaluate(expr, begin, end, reinterpret_cast<T *>(buffer));
+            writer.submit(buffer, sizeof(T) * (end - begin));
+            onSlab(begin, end);
         }
         writer.close();
     }
+
+    //! File name of the given pyramid level, e.g., "volume.L1.raw" for "volume.raw"
+    static std::string levelFilename(const std::string &filename, int level);
+
+    //! File name of the metadata sidecar (size and voxel type) read by RawVolumeImporter, e.g., "volume.raw.json"
+    static std::string metadataFilename(const std::string &filename);
+
+    //! File name of the pyramid descriptor, e.g., "volume.pyramid.json" for "volume.raw"
+    static std::string pyramidFilename(const std::string &filename);
+
+    //! Default size and number of the buffers where the voxels are converted before written
+    static constexpr uint64_t kDefaultSlabBytes = 64 * 1024 * 1024;
+    static constexpr int kDefaultNumBuffers = 3;
+
+    //! Set the size (a multiple of AsyncFileWriter::kAlignment) and number of the conversion buffers
+    void setBuffering(uint64_t slabBytes, int numBuffers) {
+        LIBCBCT_ASSERT(slabBytes > 0 && slabBytes % AsyncFileWriter::kAlignment == 0 && numBuffers >= 1,
+                       "Invalid buffering for RAW export!");
+        this->slabBytes = slabBytes;
+        this->numBuffers = numBuffers;
+    }
+
+private:
+    bool directIO = false;
+    uint64_t slabBytes = kDefaultSlabBytes;
+    int numBuffers = kDefaultNumBuffers;
+    int pyramidLevels = 0;
+    PyramidFilter pyramidFilter = PyramidFilter::Box;
+
+    template <typename T>
+    void writeAsType(const std::string &filename, const VolumeF32 &tomogram, bool normalize = false,
+                     float outMin = 0.0f, float outMax = 1.0f) const;
 };
 
 #endif  // LIBCBCT_RAW_VOLUME_EXPORTER_H
@@ -0,0 +1,69 @@
+#define LIBCBCT_API_EXPORT
+#include "RawVolumeImporter.h"
+
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "Common/Logging.h"
+#include "RawVolumeExporter.h"
+
+using json = nlohmann::json;
+namespace expr = libcbct::expr;
+
+RawVolumeImporter::RawVolumeImporter(const std::string &filename)
+    : BaseImporter{}
+    , filename{ filename } {
+    const std::string metadataName = RawVolumeExporter::metadataFilename(filename);
+    std::ifstream reader(metadataName.c_str(), std::ios::in);
+    if (reader.fail()) {
+        LIBCBCT_ERROR("Failed to open file: %s", metadataName.c_str());
+    }
+
+    const json metadata = json::parse(reader);
+    const auto &size = metadata.at("size");
+    for (int d = 0; d < 3; d++) {
+        sizes[d] = size.at(d).get<uint64_t>();
+    }
+    voxelType = volumeTypeFromName(metadata.at("type").get<std::string>());
+    open();
+}
+
+RawVolumeImporter::RawVolumeImporter(const std::string &filename, const vec3i &size, VolumeType type)
+    : BaseImporter{}
+    , filename{ filename }
+    , sizes{ (uint64_t)size.x, (uint64_t)size.y, (uint64_t)size.z }
+    , voxelType{ type } {
+    open();
+}
+
+void RawVolumeImporter::open() {
+    file = std::make_shared<MappedFile>(filename);
+    const uint64_t expected = sizes[0] * sizes[1] * sizes[2] * volumeTypeSize(voxelType);
+    if (file->size() < expected) {
+        LIBCBCT_ERROR("File is smaller than the volume (%llu < %llu bytes): %s", (unsigned long long)file->size(),
+                      (unsigned long long)expected, filename.c_str());
+    }
+}
+
+VolumeF32 RawVolumeImporter::read() const {
+    return readSlab(0, (int)sizes[2]);
+}
+
+VolumeF32 RawVolumeImporter::readSlab(int zBegin, int zEnd) const {
+    switch (voxelType) {
+    case VolumeType::Uint8:
+        return expr::cast<float>(map<uint8_t>(zBegin, zEnd));
+    case VolumeType::Uint16:
+        return expr::cast<float>(map<uint16_t>(zBegin, zEnd));
+    case VolumeType::Uint32:
+        return expr::cast<float>(map<uint32_t>(zBegin, zEnd));
+    case VolumeType::Float32:
+        return map<float>(zBegin, zEnd);
+    case VolumeType::Float64:
+        return expr::cast<float>(map<double>(zBegin, zEnd));
+    default:
+        LIBCBCT_ERROR("Unsupported volume type for RAW import!");
+        return VolumeF32();
+    }
+}
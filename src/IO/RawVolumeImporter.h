@@ -0,0 +1,71 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_RAW_VOLUME_IMPORTER_H
+#define LIBCBCT_RAW_VOLUME_IMPORTER_H
+
+#include <memory>
+
+#include "BaseImporter.h"
+#include "MappedFile.h"
+#include "Utils/Vec.h"
+#include "Utils/VolumeExpr.h"
+
+/**
+ * @brief Importer for headerless raw volumes, e.g., those written by RawVolumeExporter
+ * @details The file is memory-mapped on construction, and nothing is read until the voxels are accessed. A volume
+ * of the stored voxel type is obtained with map() without copying, and the float conversion is evaluated lazily as
+ * an expression (e.g., libcbct::expr::cast<float>(importer.map<uint16_t>())) or per slab with readSlab(), so that
+ * only the pages actually used are loaded. Since the file is mapped copy-on-write, modifying a mapped volume never
+ * changes the file.
+ */
+class LIBCBCT_API RawVolumeImporter : public BaseImporter {
+public:
+    //! Open the raw file with the size and the voxel type taken from the metadata sidecar written by the exporter
+    explicit RawVolumeImporter(const std::string &filename);
+
+    //! Open the raw file with the given size and voxel type
+    RawVolumeImporter(const std::string &filename, const vec3i &size, VolumeType type);
+
+    virtual ~RawVolumeImporter() = default;
+
+    //! Read the volume as float, which does not copy the voxels if they are stored as float
+    VolumeF32 read() const override;
+
+    //! Read the slices [zBegin, zEnd) as float, converting only the voxels in them
+    VolumeF32 readSlab(int zBegin, int zEnd) const;
+
+    //! Volume of the slices [zBegin, zEnd) sharing the memory-mapped voxels, where T must be the stored voxel type
+    template <typename T>
+    Volume<T> map(int zBegin = 0, int zEnd = -1) const {
+        LIBCBCT_ASSERT(Volume<T>().type() == voxelType, "Voxel type mismatch!");
+        if (zEnd < 0) {
+            zEnd = (int)sizes[2];
+        }
+        LIBCBCT_ASSERT(zBegin >= 0 && zBegin <= zEnd && zEnd <= (int)sizes[2], "Slab is out of the volume!");
+
+        // The mapping is kept alive by the volume through the aliasing shared pointer
+        T *voxels = reinterpret_cast<T *>(file->data()) + (uint64_t)zBegin * sizes[0] * sizes[1];
+        return Volume<T>::wrap(sizes[0], sizes[1], zEnd - zBegin, std::shared_ptr<T[]>(file, voxels));
+    }
+
+    template <int Dim>
+    typename std::enable_if<Dim >= 0 && Dim <= 2, uint64_t>::type size() const {
+        return sizes[Dim];
+    }
+
+    VolumeType type() const {
+        return voxelType;
+    }
+
+private:
+    void open();
+
+    std::string filename;
+    uint64_t sizes[3] = { 0, 0, 0 };
+    VolumeType voxelType = VolumeType::Float32;
+    std::shared_ptr<MappedFile> file = nullptr;
+};
+
+#endif  // LIBCBCT_RAW_VOLUME_IMPORTER_H
@@ -0,0 +1,103 @@
+#define LIBCBCT_API_EXPORT
+#include "TiffStackExporter.h"
+
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+#include "Common/ProgressBar.h"
+#include "Common/MemoryTracker.h"
+#include "Common/PerfCounters.h"
+#include "Common/Trace.h"
+
+namespace fs = std::filesystem;
+
+void TiffStackExporter::write(const std::string &filename, const VolumeF32 &tomogram, VolumeType type) const {
+    switch (type) {
+    case VolumeType::Uint8:
+        writeAsType<uint8_t>(filename, tomogram, CV_8UC1, true, 0.0f, 255.0f);
+        break;
+    case VolumeType::Uint16:
+        writeAsType<uint16_t>(filename, tomogram, CV_16UC1, true, 0.0f, 50000.0f);
+        break;
+    case VolumeType::Float32:
+        writeAsType<float>(filename, tomogram, CV_32FC1, false);
+        break;
+    case VolumeType::Float64:
+        writeAsType<double>(filename, tomogram, CV_64FC1, false);
+        break;
+    default:
+        LIBCBCT_ERROR("Unsupported volume type for TIFF export!");
+        break;
+    }
+}
+
+std::string TiffStackExporter::sliceFilename(const std::string &folder, int index, int numSlices) {
+    const int digits = std::max(4, (int)std::to_string(std::max(numSlices - 1, 0)).size());
+    char name[64];
+    std::snprintf(name, sizeof(name), "slice_%0*d.tif", digits, index);
+    return (fs::path(folder) / name).string();
+}
+
+template <typename T>
+void TiffStackExporter::writeAsType(const std::string &folder, const VolumeF32 &tomogram, int cvType, bool normalize,
+                                    float outMin, float outMax) const {
+    LIBCBCT_TRACE_SCOPE("export");
+    LIBCBCT_PERF_REGION("export", 0);
+    LIBCBCT_MEMORY_STAGE("export");
+    LIBCBCT_ASSERT(axis >= 0 && axis <= 2, "Slice axis must be 0, 1 or 2!");
+    fs::create_directories(folder);
+
+    float minVal = 0.0f, maxVal = 1.0f;
+    if (normalize) {
+        std::tie(minVal, maxVal) = tomogram.getMinMax();
+    }
+
+    // The slice image spans the remaining two axes, where the first of them runs along the columns
+    const int64_t sx = tomogram.size<0>();
+    const int64_t sy = tomogram.size<1>();
+    const int64_t sz = tomogram.size<2>();
+    const int64_t size[3] = { sx, sy, sz };
+    const int64_t stride[3] = { 1, sx, sx * sy };
+    const int u = axis == 0 ? 1 : 0;
+    const int v = axis == 2 ? 1 : 2;
+    const int cols = (int)size[u];
+    const int rows = (int)size[v];
+    const int nSlices = (int)size[axis];
+
+    const std::vector<int> params = { cv::IMWRITE_TIFF_COMPRESSION, (int)compression };
+    std::vector<cv::Mat> buffers(omp_get_max_threads());
+    const MemoryReservation bufferBytes(MemoryCategory::IO, buffers.size() * rows * cols * sizeof(T));
+
+    ProgressBar pbar(nSlices);
+    pbar.setDescription("EXPORT: ");
+    OMP_PARALLEL_FOR(int i = 0; i < nSlices; i++) {
+        cv::Mat &image = buffers[omp_get_thread_num()];
+        if (image.empty()) {
+            image = cv::Mat(rows, cols, cvType);
+        }
+
+        const float *base = tomogram.ptr() + i * stride[axis];
+        for (int r = 0; r < rows; r++) {
+            const float *src = base + r * stride[v];
+            T *dst = image.ptr<T>(r);
+            for (int c = 0; c < cols; c++) {
+                float value = src[c * stride[u]];
+                if (normalize) {
+                    value = outMin + (value - minVal) / (maxVal - minVal) * (outMax - outMin);
+                }
+                dst[c] = static_cast<T>(value);
+            }
+        }
+
+        const std::string name = sliceFilename(folder, i, nSlices);
+        if (!cv::imwrite(name, image, params)) {
+            LIBCBCT_ERROR("Failed to write image: %s", name.c_str());
+        }
+        pbar.step();
+    }
+}
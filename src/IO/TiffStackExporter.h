@@ -0,0 +1,48 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_TIFF_STACK_EXPORTER_H
+#define LIBCBCT_TIFF_STACK_EXPORTER_H
+
+#include "BaseExporter.h"
+
+/**
+ * @brief Exporter writing a volume as a stack of 2D TIFF images
+ * @details The filename given to write() is the output folder, where the slices perpendicular to the given axis are
+ * saved as "slice_0000.tif", "slice_0001.tif", ..., which ImageSequenceImporter can read back. The slices are
+ * extracted, converted and encoded in parallel, and each thread reuses a single slice buffer, so that the memory
+ * in flight is bounded by the number of threads rather than the number of slices.
+ */
+class LIBCBCT_API TiffStackExporter : public BaseExporter {
+public:
+    //! TIFF compression schemes (the values are the libtiff tags)
+    enum class Compression : int {
+        None = 1,
+        LZW = 5,
+        Deflate = 8,
+    };
+
+    explicit TiffStackExporter(int axis = 2, Compression compression = Compression::LZW)
+        : BaseExporter{}
+        , axis{ axis }
+        , compression{ compression } {
+    }
+    virtual ~TiffStackExporter() = default;
+
+    void write(const std::string &filename, const VolumeF32 &tomogram,
+               VolumeType type = VolumeType::Float32) const override;
+
+    //! File name of the given slice in the output folder
+    static std::string sliceFilename(const std::string &folder, int index, int numSlices);
+
+private:
+    int axis = 2;
+    Compression compression = Compression::LZW;
+
+    template <typename T>
+    void writeAsType(const std::string &folder, const VolumeF32 &tomogram, int cvType, bool normalize = false,
+                     float outMin = 0.0f, float outMax = 1.0f) const;
+};
+
+#endif  // LIBCBCT_TIFF_STACK_EXPORTER_H
@@ -0,0 +1,219 @@
+#define LIBCBCT_API_EXPORT
+#include "Phantom.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Common/Constants.h"
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+
+namespace {
+
+//! Shape in world coordinates (mm) mapped onto the unit sphere or cube by the rotation and the inverse scales
+struct WorldShape {
+    bool cuboid;
+    double center[3];
+    double invScale[3];
+    double cosA, sinA;
+    double density;
+
+    void toLocal(const double p[3], double q[3]) const {
+        q[0] = (p[0] * cosA + p[1] * sinA) * invScale[0];
+        q[1] = (-p[0] * sinA + p[1] * cosA) * invScale[1];
+        q[2] = p[2] * invScale[2];
+    }
+
+    bool contains(const double p[3]) const {
+        const double d[3] = { p[0] - center[0], p[1] - center[1], p[2] - center[2] };
+        double q[3];
+        toLocal(d, q);
+        if (cuboid) {
+            return std::abs(q[0]) <= 1.0 && std::abs(q[1]) <= 1.0 && std::abs(q[2]) <= 1.0;
+        }
+        return q[0] * q[0] + q[1] * q[1] + q[2] * q[2] <= 1.0;
+    }
+
+    //! Length of the line src + t * dir inside the shape, in units of t
+    double chord(const double src[3], const double dir[3]) const {
+        const double d[3] = { src[0] - center[0], src[1] - center[1], src[2] - center[2] };
+        double q0[3], q1[3];
+        toLocal(d, q0);
+        toLocal(dir, q1);
+
+        if (cuboid) {
+            // Slab intersection with [-1, 1]^3
+            double tMin = -std::numeric_limits<double>::infinity();
+            double tMax = std::numeric_limits<double>::infinity();
+            for (int k = 0; k < 3; k++) {
+                if (q1[k] == 0.0) {
+                    if (std::abs(q0[k]) > 1.0) {
+                        return 0.0;
+                    }
+                    continue;
+                }
+                const double t1 = (-1.0 - q0[k]) / q1[k];
+                const double t2 = (1.0 - q0[k]) / q1[k];
+                tMin = std::max(tMin, std::min(t1, t2));
+                tMax = std::min(tMax, std::max(t1, t2));
+            }
+            return std::max(0.0, tMax - tMin);
+        }
+
+        const double a = q1[0] * q1[0] + q1[1] * q1[1] + q1[2] * q1[2];
+        const double b = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2];
+        const double c = q0[0] * q0[0] + q0[1] * q0[1] + q0[2] * q0[2] - 1.0;
+        const double disc = b * b - a * c;
+        return disc > 0.0 ? 2.0 * std::sqrt(disc) / a : 0.0;
+    }
+};
+
+WorldShape toWorld(bool cuboid, const vec3f &center, const vec3f &scale, float angle, float density,
+                   const double half[3]) {
+    const double rad = angle * (double)libcbct::kPi / 180.0;
+    WorldShape w;
+    w.cuboid = cuboid;
+    for (int k = 0; k < 3; k++) {
+        w.center[k] = center[k] * half[k];
+        w.invScale[k] = 1.0 / (scale[k] * half[k]);
+    }
+    w.cosA = std::cos(rad);
+    w.sinA = std::sin(rad);
+    w.density = density;
+    return w;
+}
+
+//! The normalized coordinates [-1, 1] span the volume reconstructed by FeldkampCPU
+std::vector<WorldShape> worldShapes(const std::vector<Ellipsoid> &ellipsoids, const std::vector<Cuboid> &cuboids,
+                                    const Geometry &geometry) {
+    const double vs = voxelSize(geometry);
+    const double half[3] = { geometry.volSize.x * vs * 0.5, geometry.volSize.y * vs * 0.5,
+                             geometry.volSize.z * vs * 0.5 };
+    std::vector<WorldShape> shapes;
+    for (const Ellipsoid &e : ellipsoids) {
+        shapes.push_back(toWorld(false, e.center, e.semiAxes, e.angle, e.density, half));
+    }
+    for (const Cuboid &c : cuboids) {
+        shapes.push_back(toWorld(true, c.center, c.halfSize, c.angle, c.density, half));
+    }
+    return shapes;
+}
+
+}  // namespace
+
+Phantom Phantom::sheppLogan(float attenuation) {
+    // Modified Shepp-Logan phantom in 3D: center, semi-axes, rotation about z, density
+    static const float table[10][8] = {
+        { 0.0f, 0.0f, 0.0f, 0.69f, 0.92f, 0.81f, 0.0f, 1.0f },
+        { 0.0f, -0.0184f, 0.0f, 0.6624f, 0.874f, 0.78f, 0.0f, -0.8f },
+        { 0.22f, 0.0f, 0.0f, 0.11f, 0.31f, 0.22f, -18.0f, -0.2f },
+        { -0.22f, 0.0f, 0.0f, 0.16f, 0.41f, 0.28f, 18.0f, -0.2f },
+        { 0.0f, 0.35f, -0.15f, 0.21f, 0.25f, 0.41f, 0.0f, 0.1f },
+        { 0.0f, 0.1f, 0.25f, 0.046f, 0.046f, 0.05f, 0.0f, 0.1f },
+        { 0.0f, -0.1f, 0.25f, 0.046f, 0.046f, 0.05f, 0.0f, 0.1f },
+        { -0.08f, -0.605f, 0.0f, 0.046f, 0.023f, 0.05f, 0.0f, 0.1f },
+        { 0.0f, -0.606f, 0.0f, 0.023f, 0.023f, 0.02f, 0.0f, 0.1f },
+        { 0.06f, -0.605f, 0.0f, 0.023f, 0.046f, 0.02f, 0.0f, 0.1f },
+    };
+
+    Phantom phantom;
+    for (const auto &row : table) {
+        phantom.add(Ellipsoid{ vec3f(row[0], row[1], row[2]), vec3f(row[3], row[4], row[5]), row[6],
+                               row[7] * attenuation });
+    }
+    return phantom;
+}
+
+Phantom Phantom::cuboidInserts(float attenuation) {
+    Phantom phantom;
+    phantom.add(Ellipsoid{ vec3f(0.0f, 0.0f, 0.0f), vec3f(0.85f, 0.85f, 0.9f), 0.0f, attenuation });
+
+    // Bone, air and soft-tissue inserts, from large to small, at several rotations and heights
+    phantom.add(Cuboid{ vec3f(-0.4f, 0.0f, 0.0f), vec3f(0.15f, 0.3f, 0.5f), 0.0f, attenuation });
+    phantom.add(Cuboid{ vec3f(0.4f, 0.0f, 0.0f), vec3f(0.15f, 0.3f, 0.5f), 30.0f, -attenuation });
+    phantom.add(Cuboid{ vec3f(0.0f, 0.45f, 0.3f), vec3f(0.1f, 0.1f, 0.1f), 45.0f, 0.2f * attenuation });
+    phantom.add(Cuboid{ vec3f(0.0f, -0.45f, -0.3f), vec3f(0.05f, 0.05f, 0.2f), 0.0f, 0.5f * attenuation });
+    phantom.add(Cuboid{ vec3f(0.0f, 0.0f, 0.6f), vec3f(0.5f, 0.5f, 0.03f), 0.0f, 0.5f * attenuation });
+    return phantom;
+}
+
+VolumeF32 Phantom::project(const Geometry &geometry, int nProj) const {
+    LIBCBCT_ASSERT(nProj > 0, "Number of views must be positive!");
+    const int detWidth = geometry.detSize.x;
+    const int detHeight = geometry.detSize.y;
+    const std::vector<WorldShape> shapes = worldShapes(ellipsoidShapes, cuboidShapes, geometry);
+
+    // Same angles as the backprojection, with the source at the origin of the rotated frame of project()
+    std::vector<double> cosTheta(nProj), sinTheta(nProj);
+    for (int i = 0; i < nProj; i++) {
+        const float theta = (float)libcbct::kTwoPi * i / nProj;
+        cosTheta[i] = cosf(theta);
+        sinTheta[i] = sinf(theta);
+    }
+
+    // Rows of all the views are distributed to the threads, which balances small view counts on many cores
+    VolumeF32 sinogram(detWidth, detHeight, nProj);
+    float *const out = sinogram.ptr();
+    const int nRows = nProj * detHeight;
+    OMP_PARALLEL_FOR(int r = 0; r < nRows; r++) {
+        const int i = r / detHeight;
+        const int y = r % detHeight;
+        const double c = cosTheta[i];
+        const double s = sinTheta[i];
+        const double src[3] = { -geometry.sod * c, geometry.sod * s, 0.0 };
+        const double v = (y + 0.5 - detHeight * 0.5) * geometry.pixSize.y;
+
+        float *const row = out + (uint64_t)detWidth * r;
+        for (int x = 0; x < detWidth; x++) {
+            const double u = (x + 0.5 - detWidth * 0.5) * geometry.pixSize.x;
+            const double dir[3] = { c * geometry.sdd + s * u, -s * geometry.sdd + c * u, v };
+            const double norm = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+
+            double integral = 0.0;
+            for (const WorldShape &shape : shapes) {
+                integral += shape.density * shape.chord(src, dir);
+            }
+            row[x] = (float)(integral * norm);
+        }
+    }
+    return sinogram;
+}
+
+VolumeF32 Phantom::voxelize(const Geometry &geometry, int supersampling) const {
+    LIBCBCT_ASSERT(supersampling > 0, "Supersampling must be positive!");
+    const vec3i volSize = geometry.volSize;
+    const std::vector<WorldShape> shapes = worldShapes(ellipsoidShapes, cuboidShapes, geometry);
+
+    // Same voxel-to-world transform as vox2pix(), with the samples spread over the voxel around it
+    const double vs = voxelSize(geometry);
+    const int n = supersampling;
+    const auto world = [&](int i, int sub, int size) { return ((i - size * 0.5) + (sub + 0.5) / n - 0.5) * vs; };
+
+    VolumeF32 volume(volSize.x, volSize.y, volSize.z);
+    float *const out = volume.ptr();
+    const int nRows = volSize.y * volSize.z;
+    OMP_PARALLEL_FOR(int r = 0; r < nRows; r++) {
+        const int y = r % volSize.y;
+        const int z = r / volSize.y;
+        float *const row = out + (uint64_t)volSize.x * r;
+        for (int x = 0; x < volSize.x; x++) {
+            double sum = 0.0;
+            for (int sz = 0; sz < n; sz++) {
+                for (int sy = 0; sy < n; sy++) {
+                    for (int sx = 0; sx < n; sx++) {
+                        const double p[3] = { world(x, sx, volSize.x), world(y, sy, volSize.y),
+                                              world(z, sz, volSize.z) };
+                        for (const WorldShape &shape : shapes) {
+                            if (shape.contains(p)) {
+                                sum += shape.density;
+                            }
+                        }
+                    }
+                }
+            }
+            row[x] = (float)(sum / (n * n * n));
+        }
+    }
+    return volume;
+}
@@ -0,0 +1,92 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_PHANTOM_H
+#define LIBCBCT_PHANTOM_H
+
+#include <vector>
+
+#include "Common/Api.h"
+#include "Geometry/GeometryBase.h"
+#include "Utils/Vec.h"
+#include "Utils/Volume.h"
+
+/**
+ * @brief Ellipsoid of a phantom
+ * @details The center and semi-axes are in the normalized coordinates where [-1, 1]^3 is the reconstructed volume,
+ * and the density is added to the attenuation (per mm) inside the ellipsoid.
+ */
+struct Ellipsoid {
+    vec3f center;
+    vec3f semiAxes;
+    float angle;  // Rotation about the z-axis in degrees
+    float density;
+};
+
+//! Cuboid of a phantom, in the same coordinates as the ellipsoids
+struct Cuboid {
+    vec3f center;
+    vec3f halfSize;
+    float angle;  // Rotation about the z-axis in degrees
+    float density;
+};
+
+/**
+ * @brief Analytic phantom made of ellipsoids and cuboids, which gives exact cone-beam projections of any size
+ * @details The projections follow the circular trajectory of FeldkampCPU: view i is taken at the angle
+ * 2 pi i / nProj, and each detector pixel integrates the attenuation along the ray from the source to its center.
+ * The result is the log-transformed sinogram, which can be reconstructed without any import. The densities of
+ * overlapping shapes are added, and voxelize() gives the matching ground truth on the reconstruction grid.
+ */
+class LIBCBCT_API Phantom {
+public:
+    Phantom() {
+    }
+
+    /**
+     * @brief Modified 3D Shepp-Logan phantom (ten ellipsoids of the head)
+     * @details The densities are those of the modified phantom (1 for the skull, 0.2 for the brain, ...) times the
+     * given attenuation per mm.
+     */
+    static Phantom sheppLogan(float attenuation = 0.02f);
+
+    /**
+     * @brief Ellipsoidal body of water with cuboid inserts of several densities, sizes and rotations
+     * @details The sharp edges of the cuboids along all three axes show the resolution and the cone-beam
+     * artifacts, which the smooth ellipsoids hide.
+     */
+    static Phantom cuboidInserts(float attenuation = 0.02f);
+
+    void add(const Ellipsoid &ellipsoid) {
+        ellipsoidShapes.push_back(ellipsoid);
+    }
+
+    void add(const Cuboid &cuboid) {
+        cuboidShapes.push_back(cuboid);
+    }
+
+    const std::vector<Ellipsoid> &ellipsoids() const {
+        return ellipsoidShapes;
+    }
+
+    const std::vector<Cuboid> &cuboids() const {
+        return cuboidShapes;
+    }
+
+    //! Projections of detSize.x x detSize.y pixels for nProj views, computed in parallel over the views and rows
+    VolumeF32 project(const Geometry &geometry, int nProj) const;
+
+    /**
+     * @brief Densities on the voxel grid of FeldkampCPU
+     * @details Each voxel averages supersampling^3 points regularly spaced inside it, so that the voxels on the
+     * edges of the shapes get the partial volume.
+     */
+    VolumeF32 voxelize(const Geometry &geometry, int supersampling = 2) const;
+
+private:
+    std::vector<Ellipsoid> ellipsoidShapes;
+    std::vector<Cuboid> cuboidShapes;
+};
+
+#endif  // LIBCBCT_PHANTOM_H
@@ -0,0 +1,190 @@
+#define LIBCBCT_API_EXPORT
+#include "AutoTuner.h"
+
+#include <fstream>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+#include <nlohmann/json.hpp>
+
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+#include "Common/Roofline.h"
+#include "Common/Timing.h"
+#include "Phantom/Phantom.h"
+#include "FeldkampCPU.h"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+const int kBrickSizes[] = { 4, 8, 16, 32 };
+const int kViewBatches[] = { 1, 2, 4, 8 };
+
+std::mutex tunerMutex;
+bool autoTune = false;
+int currentThreads = 0;
+TuningConfig currentConfig;
+
+//! All the threads, and halves of it down to a quarter (SMT siblings and sockets often do not pay off)
+std::vector<int> threadCandidates(int maxThreads) {
+    std::vector<int> candidates;
+    for (int t = maxThreads; t >= std::max(1, maxThreads / 4); t /= 2) {
+        candidates.push_back(t);
+        if (t == 1) {
+            break;
+        }
+    }
+    return candidates;
+}
+
+TuningConfig tuneLocked(const AutoTuner::Options &options) {
+    const int maxThreads = omp_get_max_threads();
+    LIBCBCT_INFO("Tuning the reconstruction for %d threads...", maxThreads);
+
+    const Geometry geometry(vec2i(options.detSize, options.detSize), vec2f(0.2f, 0.2f), vec3i(options.volSize), 500.0f,
+                            1000.0f);
+    const VolumeF32 sinogram = Phantom::sheppLogan().project(geometry, options.nViews);
+    const ReconstructionControl control = ReconstructionControl::silent();
+
+    FeldkampCPU fdk(RampFilter::SheppLogan, TuningConfig().brickSize);
+    fdk.setKeepSession(true);
+    const VolumeF32 filtered = fdk.filterProjections(sinogram, control);
+
+    const auto timeBackprojection = [&](const TuningConfig &config) {
+        fdk.setTuning(config);
+        fdk.backproject(filtered, geometry, control);  // Untimed, which allocates the session
+        return bestOf(options.repeat, [&] { fdk.backproject(filtered, geometry, control); }, options.minSeconds);
+    };
+
+    // Brick size and view batch size with all the threads
+    TuningConfig best;
+    double bestSec = 1.0e30;
+    for (int brickSize : kBrickSizes) {
+        for (int viewBatch : kViewBatches) {
+            TuningConfig config;
+            config.brickSize = brickSize;
+            config.viewBatch = viewBatch;
+            const double sec = timeBackprojection(config);
+            LIBCBCT_DEBUG("brick %2d, batch %d: %.2f ms", brickSize, viewBatch, sec * 1.0e3);
+            if (sec < bestSec) {
+                bestSec = sec;
+                best = config;
+            }
+        }
+    }
+
+    // Threads of the backprojection and of the filtering, each with the others fixed
+    for (int threads : threadCandidates(maxThreads)) {
+        TuningConfig config = best;
+        config.backprojectThreads = threads == maxThreads ? 0 : threads;
+        const double sec = timeBackprojection(config);
+        LIBCBCT_DEBUG("backprojection with %d threads: %.2f ms", threads, sec * 1.0e3);
+        if (sec < bestSec) {
+            bestSec = sec;
+            best = config;
+        }
+    }
+
+    double bestFilterSec = 1.0e30;
+    for (int threads : threadCandidates(maxThreads)) {
+        TuningConfig config = best;
+        config.filterThreads = threads == maxThreads ? 0 : threads;
+        fdk.setTuning(config);
+        const double sec =
+            bestOf(options.repeat, [&] { fdk.filterProjections(sinogram, control); }, options.minSeconds);
+        LIBCBCT_DEBUG("filtering with %d threads: %.2f ms", threads, sec * 1.0e3);
+        if (sec < bestFilterSec) {
+            bestFilterSec = sec;
+            best.filterThreads = config.filterThreads;
+        }
+    }
+
+    const double updates = (double)options.volSize * options.volSize * options.volSize * options.nViews;
+    LIBCBCT_INFO("Tuned: brick %d, batch %d, filter threads %d, backprojection threads %d (%.3f GVU/s)",
+                 best.brickSize, best.viewBatch, best.filterThreads, best.backprojectThreads,
+                 updates / bestSec * 1.0e-9);
+    return best;
+}
+
+}  // namespace
+
+TuningConfig AutoTuner::current() {
+    std::lock_guard<std::mutex> lock(tunerMutex);
+    const int threads = omp_get_max_threads();
+    if (currentThreads == threads) {
+        return currentConfig;
+    }
+
+    TuningConfig config;
+    if (load(config)) {
+        LIBCBCT_DEBUG("Tuning loaded: %s", tuningPath().c_str());
+    } else if (autoTune) {
+        config = tuneLocked(Options());
+        save(config);
+    }
+    currentConfig = config;
+    currentThreads = threads;
+    return config;
+}
+
+void AutoTuner::setAutoTune(bool on) {
+    std::lock_guard<std::mutex> lock(tunerMutex);
+    autoTune = on;
+}
+
+TuningConfig AutoTuner::tune(const Options &options) {
+    std::lock_guard<std::mutex> lock(tunerMutex);
+    const TuningConfig config = tuneLocked(options);
+    save(config);
+    currentConfig = config;
+    currentThreads = omp_get_max_threads();
+    return config;
+}
+
+bool AutoTuner::load(TuningConfig &config) {
+    std::ifstream reader(tuningPath().c_str(), std::ios::in);
+    if (reader.fail()) {
+        return false;
+    }
+    const json root = json::parse(reader, nullptr, false);
+    if (root.is_discarded() || root.value("threads", 0) != omp_get_max_threads()) {
+        return false;
+    }
+
+    TuningConfig loaded;
+    loaded.brickSize = root.value("brickSize", loaded.brickSize);
+    loaded.viewBatch = root.value("viewBatch", loaded.viewBatch);
+    loaded.filterThreads = root.value("filterThreads", loaded.filterThreads);
+    loaded.backprojectThreads = root.value("backprojectThreads", loaded.backprojectThreads);
+    if (loaded.brickSize <= 0 || (loaded.brickSize & (loaded.brickSize - 1)) != 0 || loaded.viewBatch <= 0) {
+        LIBCBCT_WARN("Invalid tuning file is ignored: %s", tuningPath().c_str());
+        return false;
+    }
+    config = loaded;
+    return true;
+}
+
+void AutoTuner::save(const TuningConfig &config) {
+    const std::string path = tuningPath();
+    std::ofstream writer(path.c_str(), std::ios::out);
+    if (writer.fail()) {
+        LIBCBCT_WARN("Failed to save the tuning: %s", path.c_str());
+        return;
+    }
+    const json root = { { "host", HostCalibration::hostName() },
+                        { "threads", omp_get_max_threads() },
+                        { "brickSize", config.brickSize },
+                        { "viewBatch", config.viewBatch },
+                        { "filterThreads", config.filterThreads },
+                        { "backprojectThreads", config.backprojectThreads } };
+    writer << root.dump(2) << std::endl;
+    LIBCBCT_DEBUG("Tuning saved: %s", path.c_str());
+}
+
+std::string AutoTuner::tuningPath() {
+    return (fs::path(HostCalibration::cacheDirectory()) / ("tuning-" + HostCalibration::hostName() + ".json")).string();
+}
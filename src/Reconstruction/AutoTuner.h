@@ -0,0 +1,63 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_AUTO_TUNER_H
+#define LIBCBCT_AUTO_TUNER_H
+
+#include <string>
+
+#include "Common/Api.h"
+
+//! Parameters of FeldkampCPU that depend on the host rather than on the scan
+struct LIBCBCT_API TuningConfig {
+    //! Edge length of the bricks of the accumulator (a power of two)
+    int brickSize = 8;
+    //! Number of views backprojected in a single pass over the accumulator
+    int viewBatch = 1;
+    //! Threads of the filtering and of the backprojection (zero for all the OpenMP threads)
+    int filterThreads = 0;
+    int backprojectThreads = 0;
+};
+
+/**
+ * @brief Search of the fastest TuningConfig for this host
+ * @details The tuner backprojects a small phantom over a grid of brick sizes and view batch sizes with all the
+ * threads, then tries fewer threads for the backprojection with the best of them and for the filtering. The best
+ * configuration is saved in tuning-<host>.json in the cache directory (see HostCalibration), together with the
+ * number of OpenMP threads it was tuned for. FeldkampCPU loads it automatically when it is constructed without an
+ * explicit brick size. The tuning runs on the first use only in the auto-tune mode, and the defaults are used
+ * otherwise until a tuning file exists.
+ */
+class LIBCBCT_API AutoTuner {
+public:
+    //! Size of the calibration reconstructions, each of which is timed at least "repeat" times and minSeconds
+    struct Options {
+        int detSize = 128;
+        int nViews = 16;
+        int volSize = 128;
+        int repeat = 2;
+        double minSeconds = 0.05;
+    };
+
+    //! Tuning of this host and thread count, from the tuning file, from a new tuning in auto-tune mode, or default
+    static TuningConfig current();
+
+    //! Tune on the first use when no tuning file exists for this host and thread count
+    static void setAutoTune(bool on);
+
+    //! Run the tuning now, save it in the tuning file and make it the current one
+    static TuningConfig tune(const Options &options);
+    static TuningConfig tune() {
+        return tune(Options());
+    }
+
+    //! Load the tuning file, returning false if there is none for the current thread count
+    static bool load(TuningConfig &config);
+
+    static void save(const TuningConfig &config);
+
+    static std::string tuningPath();
+};
+
+#endif  // LIBCBCT_AUTO_TUNER_H
@@ -1,94 +1,281 @@
 #define LIBCBCT_API_EXPORT
 #include "FeldkampCPU.h"
 
-#define _USE_MATH_DEFINES
 #include <cmath>
+#include <chrono>
 #include <vector>
+#include <algorithm>
 
-#include <opencv2/opencv.hpp>
-
-#include "Common/Constants.h"
+#include "Common/Hash.h"
 #include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
 #include "Common/OpenMP.h"
-#include "Common/ProgressBar.h"
-#include "Utils/ImageUtils.h"
+#include "Common/Parallel.h"
+#include "Common/PerfCounters.h"
+
+namespace {
+
+/**
+ * FLOPs of a voxel update in ReconstructionSession::backprojectViews: about 24 in project() (rotation, perspective
+ * division, distance weight and detector coordinates), 13 in bilerp() and 3 to weight and accumulate the sample.
+ */
+constexpr double kFlopsPerUpdate = 40.0;
 
-#include "pocketfft_hdronly.h"
+}  // namespace
 
-namespace pfft = pocketfft;
+VolumeF32 FeldkampCPU::reconstruct(const VolumeF32 &sinogram, const Geometry &geometry,
+                                   const ReconstructionControl &control) const {
+    LIBCBCT_ASSERT((int)sinogram.size<0>() == geometry.detSize.x && (int)sinogram.size<1>() == geometry.detSize.y,
+                   "Projection size does not match the geometry!");
+    const uint64_t key =
+        checkpoint ? checkpointKey(reinterpret_cast<const char *>(sinogram.ptr()),
+                                   sizeof(float) * sinogram.size<0>() * sinogram.size<1>(), sinogram.size<2>(),
+                                   geometry, 0)
+                   : 0;
+    return backprojectViews(sinogram.size<2>(), geometry, control, key, true,
+                            [&](int i, float *buffer) -> const float * {
+                                ReconstructionSession::loadView(sinogram, i, buffer);
+                                return buffer;
+                            });
+}
+
+VolumeF32 FeldkampCPU::reconstruct(const VolumeU16 &counts, float freeRay, const Geometry &geometry,
+                                   const ReconstructionControl &control) const {
+    LIBCBCT_ASSERT((int)counts.size<0>() == geometry.detSize.x && (int)counts.size<1>() == geometry.detSize.y,
+                   "Projection size does not match the geometry!");
+    const uint64_t key =
+        checkpoint ? checkpointKey(reinterpret_cast<const char *>(counts.ptr()),
+                                   sizeof(uint16_t) * counts.size<0>() * counts.size<1>(), counts.size<2>(),
+                                   geometry, 2, freeRay)
+                   : 0;
+    return backprojectViews(counts.size<2>(), geometry, control, key, true,
+                            [&](int i, float *buffer) -> const float * {
+                                ReconstructionSession::loadView(counts, freeRay, i, buffer);
+                                return buffer;
+                            });
+}
 
-VolumeF32 FeldkampCPU::reconstruct(const VolumeF32 &sinogram, const Geometry &geometry) const {
-    const int detWidth = sinogram.size<0>();
-    const int detHeight = sinogram.size<1>();
-    const int nProj = sinogram.size<2>();
+VolumeF32 FeldkampCPU::backproject(const VolumeF32 &filtered, const Geometry &geometry,
+                                   const ReconstructionControl &control) const {
+    LIBCBCT_ASSERT((int)filtered.size<0>() == geometry.detSize.x && (int)filtered.size<1>() == geometry.detSize.y,
+                   "Projection size does not match the geometry!");
+    const uint64_t key =
+        checkpoint ? checkpointKey(reinterpret_cast<const char *>(filtered.ptr()),
+                                   sizeof(float) * filtered.size<0>() * filtered.size<1>(), filtered.size<2>(),
+                                   geometry, 1)
+                   : 0;
+    const uint64_t projSize = filtered.size<0>() * filtered.size<1>();
+    return backprojectViews(filtered.size<2>(), geometry, control, key, false,
+                            [&](int i, float *) -> const float * { return filtered.ptr() + projSize * i; });
+}
 
-    // Allocate output volume
+template <typename LoadView>
+VolumeF32 FeldkampCPU::backprojectViews(int nProj, const Geometry &geometry, const ReconstructionControl &control,
+                                        uint64_t key, bool needsFilter, LoadView &&loadView) const {
     const vec3i volSize = geometry.volSize;
     LIBCBCT_DEBUG("Volume size: %dx%dx%d", volSize.x, volSize.y, volSize.z);
-    VolumeF32 tomogram(volSize.x, volSize.y, volSize.z);
-
-    // Precompute filter kernel
-    std::vector<float> H(detWidth);
-    for (int x = 0; x < detWidth; x++) {
-        const float q = std::min(x, detWidth - x) / (0.5f * detWidth);
-        if (filter == RampFilter::RamLak) {
-            H[x] = std::abs(q);
-        } else if (filter == RampFilter::SheppLogan) {
-            H[x] = (2.0f * (float)libcbct::kOneOverPi) * std::abs(std ::sin((float)libcbct::kHalfPi * q));
-        } else {
-            LIBCBCT_ERROR("Unknown ramp filter specified!");
-        }
-    }
 
-    std::vector<float> tempInOut(detWidth * detHeight);
-    std::vector<std::complex<float>> tempCplx(detWidth * detHeight);
-
-    pfft::shape_t shape{ (size_t)detHeight, (size_t)detWidth };
-    pfft::stride_t strideReal{ (int64_t)(detWidth * sizeof(float)), (int64_t)sizeof(float) };
-    pfft::stride_t strideCplx{ (int64_t)(detWidth * sizeof(std::complex<float>)),
-                               (int64_t)sizeof(std::complex<float>) };
-    pfft::shape_t axes{ 1 };
-
-    ProgressBar pbar(nProj);
-    pbar.setDescription("RECON: ");
-    for (int i = 0; i < nProj; i++) {
-        // Copy sinogram to temp buffer
-        float *const ptr = sinogram.ptr() + (detWidth * detHeight * (uint64_t)i);
-        for (int y = 0; y < detHeight; ++y) {
-            for (int x = 0; x < detWidth; ++x) {
-                tempInOut[y * detWidth + x] = ptr[y * detWidth + x];
+    // Calibration is taken before anything is allocated, in case the thread count changed since it was enabled
+    const HostCalibration host = rooflineReport ? HostCalibration::get() : HostCalibration();
+
+    // Filter, FFT plan, geometry tables and buffers are reused from the last call with the same geometry
+    const std::shared_ptr<ReconstructionSession> sess = acquireSession(geometry, nProj);
+
+    // The accumulator is freed when the call returns, also by an exception, unless it is kept for the next scan
+    struct ReleaseAccumulator {
+        ReconstructionSession *sess;
+        ~ReleaseAccumulator() {
+            if (sess) {
+                sess->release();
             }
         }
+    } releaseAccum{ keepSession ? nullptr : sess.get() };
 
-        // pocketfft c2c
-        pfft::r2c(shape, strideReal, strideCplx, axes, true, tempInOut.data(), tempCplx.data(), 1.0f, 0);
-
-        // Apply filter in frequency domain
-        for (int y = 0; y < detHeight; y++) {
-            for (int x = 0; x < detWidth; x++) {
-                const float q = std::min(x, detWidth - x) / (0.5f * detWidth);
-                tempCplx[y * detWidth + x] *= H[x];
+    const ProjectionFilter &projFilter = sess->projectionFilter();
+    const int viewBatch = sess->viewBatchSize();
+    std::vector<const float *> views(viewBatch);
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = [&] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    // Views #first, ..., #first + count - 1 are filtered into the buffers and backprojected in a single pass
+    const auto processViews = [&](BrickedVolumeF32 &accum, int first, int count, int zOffset) {
+        {
+            const ScopedThreadCount threads(tuning.filterThreads);
+            for (int j = 0; j < count; j++) {
+                float *const buffer = sess->viewBuffer(j);
+                views[j] = loadView(first + j, buffer);
+                if (needsFilter) {
+                    projFilter.apply(buffer);
+                }
             }
         }
+        const ScopedThreadCount threads(tuning.backprojectThreads);
+        sess->backprojectViews(accum, views.data(), first, count, zOffset);
+    };
+
+    const int height = slabHeight <= 0 ? volSize.z : std::min(slabHeight, volSize.z);
+    if (height == volSize.z) {
+        // Output volume is accumulated brick by brick during the backprojection
+        BrickedVolumeF32 *accum = nullptr;
+        {
+            LIBCBCT_MEMORY_STAGE("backprojection");
+            accum = &sess->accumulator(volSize.z);
+            const ReconstructionCheckpoint::Lease lease(checkpoint.get());
+            const int firstView = checkpoint ? checkpoint->restore(key, *accum) : 0;
 
-        // pocketfft c2r
-        pfft::c2r(shape, strideCplx, strideReal, axes, false, tempCplx.data(), tempInOut.data(), 1.0f / detWidth, 0);
-
-        // Backprojection
-        OMP_PARALLEL_FOR(int z = 0; z < volSize.z; z++) {
-            for (int y = 0; y < volSize.y; y++) {
-                for (int x = 0; x < volSize.x; x++) {
-                    const float theta = (float)libcbct::kTwoPi * i / nProj;
-                    const vec3f uvw = vox2pix(vec3i(x, y, z), theta, geometry);
-                    if (uvw.x >= 0 && uvw.y >= 0 && uvw.x < detWidth && uvw.y < detHeight) {
-                        tomogram(x, y, z) +=
-                            bilerp(tempInOut.data(), detWidth, detHeight, uvw.x - 0.5f, uvw.y - 0.5f) * uvw.z / nProj;
-                    }
+            // A cancelled reconstruction leaves the last checkpoint, from which it can be resumed
+            ReconstructionMonitor monitor(control, nProj - firstView);
+            const uint64_t voxels = (uint64_t)volSize.x * volSize.y * volSize.z;
+            for (int i = firstView; i < nProj;) {
+                // Batches end on the checkpoint interval, so that the checkpoints are taken at the same views
+                int end = std::min(i + viewBatch, nProj);
+                if (checkpoint) {
+                    const int interval = checkpoint->saveInterval();
+                    end = std::min(end, (i / interval + 1) * interval);
+                }
+                monitor.throwIfCancelled();
+                processViews(*accum, i, end - i, 0);
+                if (checkpoint && end < nProj) {
+                    checkpoint->save(key, *accum, end);
                 }
+                monitor.step(end - i, voxels * (end - i));
+                i = end;
+            }
+
+            if (checkpoint) {
+                checkpoint->finish();
+            }
+            if (rooflineReport) {
+                reportRoofline(geometry, nProj - firstView, 1, viewBatch, needsFilter, elapsed(), host);
             }
         }
-        pbar.step();
+
+        LIBCBCT_MEMORY_STAGE("conversion");
+        return accum->toVolume();
+    }
+
+    // Slab-wise backprojection, where the views are loaded and filtered again for each slab
+    const int nSlabs = (volSize.z + height - 1) / height;
+    LIBCBCT_DEBUG("Backprojection in %d slabs of %d slices", nSlabs, height);
+    if (checkpoint) {
+        LIBCBCT_WARN("Checkpoints are not taken in the slab-wise backprojection");
+    }
+
+    LIBCBCT_MEMORY_STAGE("backprojection");
+    VolumeF32 volume(volSize.x, volSize.y, volSize.z);
+    ReconstructionMonitor monitor(control, nProj * nSlabs);
+    for (int s = 0; s < nSlabs; s++) {
+        const int zOffset = s * height;
+        BrickedVolumeF32 &accum = sess->accumulator(std::min(height, volSize.z - zOffset));
+        const uint64_t voxels = (uint64_t)volSize.x * volSize.y * accum.size<2>();
+        for (int i = 0; i < nProj; i += viewBatch) {
+            const int count = std::min(viewBatch, nProj - i);
+            monitor.throwIfCancelled();
+            processViews(accum, i, count, zOffset);
+            monitor.step(count, voxels * count);
+        }
+        accum.copyTo(volume, zOffset);
+    }
+    if (rooflineReport) {
+        reportRoofline(geometry, nProj, nSlabs, viewBatch, needsFilter, elapsed(), host);
+    }
+    return volume;
+}
+
+VolumeF32 FeldkampCPU::filterProjections(const VolumeF32 &sinogram, const ReconstructionControl &control) const {
+    return filterViews(sinogram.size<0>(), sinogram.size<1>(), sinogram.size<2>(), control,
+                       [&](int i, float *out) { ReconstructionSession::loadView(sinogram, i, out); });
+}
+
+VolumeF32 FeldkampCPU::filterProjections(const VolumeU16 &counts, float freeRay,
+                                         const ReconstructionControl &control) const {
+    return filterViews(counts.size<0>(), counts.size<1>(), counts.size<2>(), control,
+                       [&](int i, float *out) { ReconstructionSession::loadView(counts, freeRay, i, out); });
+}
+
+template <typename LoadView>
+VolumeF32 FeldkampCPU::filterViews(int detWidth, int detHeight, int nProj, const ReconstructionControl &control,
+                                   LoadView &&loadView) const {
+    LIBCBCT_MEMORY_STAGE("filter");
+    VolumeF32 filtered(detWidth, detHeight, nProj);
+
+    // Projections are filtered independently, so that each thread runs single-threaded FFTs on its own scratch
+    const ScopedThreadCount threads(tuning.filterThreads);
+    const ProjectionFilter projFilter(filter, detWidth, detHeight);
+
+    // Exceptions cannot leave the parallel loop, so that the remaining views are skipped after the cancellation
+    ReconstructionMonitor monitor(control, nProj, "FILTER: ");
+    LIBCBCT_PERF_REGION("filter", 0);
+    float *const out = filtered.ptr();
+    OMP_PARALLEL_FOR(int i = 0; i < nProj; i++) {
+        if (monitor.cancelled()) {
+            continue;
+        }
+        float *const proj = out + (uint64_t)detWidth * detHeight * i;
+        loadView(i, proj);
+        projFilter.apply(proj, omp_get_thread_num());
+        monitor.step();
+    }
+    monitor.finish();
+    monitor.throwIfCancelled();
+
+    return filtered;
+}
+
+std::shared_ptr<ReconstructionSession> FeldkampCPU::acquireSession(const Geometry &geometry, int nProj) const {
+    // The cached session is replaced when it is busy in another thread or the geometry changes
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    if (!session || session.use_count() > 1 ||
+        !session->matches(geometry, nProj, filter, tuning.brickSize, tuning.viewBatch)) {
+        session = nullptr;
+        session = std::make_shared<ReconstructionSession>(geometry, nProj, filter, tuning.brickSize,
+                                                          tuning.viewBatch);
+    }
+    return session;
+}
+
+void FeldkampCPU::reportRoofline(const Geometry &geometry, int nViews, int nSlabs, int viewBatch,
+                                 bool needsFilter, double seconds, const HostCalibration &host) const {
+    const double voxels = (double)geometry.volSize.x * geometry.volSize.y * geometry.volSize.z;
+    const double pixels = (double)geometry.detSize.x * geometry.detSize.y;
+    const double passes = (double)nViews * nSlabs;
+
+    // Each batch of views reads and writes the float accumulator once, and each view reads its projection once (the
+    // samples of neighbouring voxels hit the cache). A filtered view is also copied into the buffer and filtered.
+    const double floatsPerPixel = needsFilter ? 5.0 : 1.0;
+    const double batches = std::ceil((double)nViews / viewBatch);
+    const double bytes = 2.0 * sizeof(float) * voxels * batches + passes * pixels * sizeof(float) * floatsPerPixel;
+
+    // Real FFT forward and backward (about 2.5 N log2 N each) and the multiplication by the ramp, per row
+    const double width = geometry.detSize.x;
+    const double filterFlops =
+        needsFilter ? passes * geometry.detSize.y * width * (5.0 * std::log2(width) + 1.0) : 0.0;
+    const double updates = voxels * nViews;
+    const double flops = kFlopsPerUpdate * updates + filterFlops;
+
+    const RooflineReport report = RooflineReport::evaluate(updates, bytes, flops, seconds, host);
+    LIBCBCT_INFO("%s", report.summary().c_str());
+
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    roofline = report;
+}
+
+uint64_t FeldkampCPU::checkpointKey(const char *projections, uint64_t projBytes, int nProj, const Geometry &geometry,
+                                    int kind, float freeRay) const {
+    // Projections are hashed in parallel, and their hashes are combined in order
+    std::vector<uint64_t> projHashes(nProj);
+    OMP_PARALLEL_FOR(int i = 0; i < nProj; i++) {
+        Hasher hasher;
+        hasher.addBytes(projections + projBytes * i, projBytes);
+        projHashes[i] = hasher.value();
     }
 
-    return tomogram;
+    Hasher hasher;
+    hasher.addBytes(projHashes.data(), sizeof(uint64_t) * nProj);
+    hasher.add(projBytes, nProj);
+    hasher.add(geometry.detSize.x, geometry.detSize.y, geometry.pixSize.x, geometry.pixSize.y);
+    hasher.add(geometry.volSize.x, geometry.volSize.y, geometry.volSize.z, geometry.sod, geometry.sdd);
+    hasher.add((int)filter, tuning.brickSize, kind, freeRay);
+    return hasher.value();
 }
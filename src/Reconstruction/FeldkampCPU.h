@@ -5,19 +5,160 @@
 #ifndef LIBCBCT_FELDKAMP_CPU_H
 #define LIBCBCT_FELDKAMP_CPU_H
 
+#include <memory>
+#include <mutex>
+
+#include "AutoTuner.h"
 #include "ReconstructionBase.h"
+#include "ReconstructionCheckpoint.h"
+#include "ReconstructionSession.h"
+#include "Common/Roofline.h"
+#include "Utils/BrickedVolume.h"
 
 class LIBCBCT_API FeldkampCPU : public ReconstructionBase {
 public:
-    FeldkampCPU(RampFilter filter = RampFilter::SheppLogan)
+    /**
+     * @brief Reconstruction with the given brick size, or with the tuning of the host if it is zero
+     * @details An explicit brick size uses the defaults of the other parameters (see TuningConfig), so that the
+     * results do not depend on the tuning file of the host.
+     */
+    FeldkampCPU(RampFilter filter = RampFilter::SheppLogan, int brickSize = 0)
         : ReconstructionBase()
-        , filter(filter) {
+        , filter(filter)
+        , tuning(brickSize > 0 ? TuningConfig{ brickSize } : AutoTuner::current()) {
     }
     ~FeldkampCPU() = default;
-    VolumeF32 reconstruct(const VolumeF32 &sinogram, const Geometry &geometry) const override;
+
+    using ReconstructionBase::reconstruct;
+    VolumeF32 reconstruct(const VolumeF32 &sinogram, const Geometry &geometry,
+                          const ReconstructionControl &control) const override;
+
+    /**
+     * @brief Reconstruct from the raw detector counts, which halves the memory of the sinogram
+     * @details Each view is log-transformed as -log((count + 1) / freeRay) right before it is filtered, which gives
+     * the same result as reconstructing the log-transformed sinogram in float.
+     */
+    VolumeF32 reconstruct(const VolumeU16 &counts, float freeRay, const Geometry &geometry,
+                          const ReconstructionControl &control = ReconstructionControl()) const;
+
+    /**
+     * @brief First half of reconstruct(): ramp-filter all the projections in parallel
+     * @details The filtered projections depend only on the detector, not on the reconstructed volume, so that they
+     * can be cached (see FilteredProjectionCache) and backprojected for different volume sizes.
+     */
+    VolumeF32 filterProjections(const VolumeF32 &sinogram,
+                                const ReconstructionControl &control = ReconstructionControl()) const;
+
+    //! Same as above, but from the raw detector counts (see the reconstruct() for the counts)
+    VolumeF32 filterProjections(const VolumeU16 &counts, float freeRay,
+                                const ReconstructionControl &control = ReconstructionControl()) const;
+
+    //! Second half of reconstruct(): backproject the projections returned by filterProjections()
+    VolumeF32 backproject(const VolumeF32 &filtered, const Geometry &geometry,
+                          const ReconstructionControl &control = ReconstructionControl()) const;
+
+    RampFilter rampFilter() const {
+        return filter;
+    }
+
+    //! Brick size, view batch size and thread counts, which are bit-identical in the result
+    void setTuning(const TuningConfig &config) {
+        tuning = config;
+    }
+
+    const TuningConfig &tuningConfig() const {
+        return tuning;
+    }
+
+    /**
+     * @brief Save the partial volume every "interval" views during the backprojection
+     * @details With "resume", the backprojection continues from the checkpoint left by an interrupted run with the
+     * same projections and settings, and the result is bit-identical to that of an uninterrupted run. The
+     * checkpoint is deleted once the reconstruction completes. A checkpoint belongs to one run at a time, so that a
+     * concurrent reconstruction with the checkpoint (e.g., by reconstructAsync()) throws std::runtime_error.
+     */
+    void setCheckpoint(const std::string &filename, int interval, bool resume = true) {
+        checkpoint = std::make_shared<ReconstructionCheckpoint>(filename, interval, resume);
+    }
+
+    /**
+     * @brief Backproject the volume in slabs of the given number of z-slices (zero for the whole volume at once)
+     * @details Only a slab of the accumulator is allocated at a time, and it is copied into the output volume when
+     * all the views are accumulated, which saves a volume-sized buffer at the cost of filtering the views once per
+     * slab. The result is bit-identical to that without slabs. Checkpoints are taken only without slabs.
+     */
+    void setSlabHeight(int height) {
+        slabHeight = height;
+    }
+
+    /**
+     * @brief Log the throughput of each backprojection against the roofline of the host
+     * @details The streaming bandwidth and peak FLOP rate of the host are calibrated when the report is enabled and
+     * cached (see HostCalibration), so that the buffers of the calibration are not allocated during a reconstruction
+     * and do not count in the peak memory of its stages. The bytes and FLOPs of the run are estimated from the sizes
+     * of the volume and the projections, so that the report tells whether the backprojection is memory- or
+     * compute-bound and how far it is from the attainable throughput.
+     */
+    void setRooflineReport(bool on) {
+        rooflineReport = on;
+        if (on) {
+            HostCalibration::get();
+        }
+    }
+
+    //! Report of the last reconstruction with setRooflineReport(true)
+    RooflineReport lastRooflineReport() const {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        return roofline;
+    }
+
+    /**
+     * @brief Keep the volume-sized accumulator in the session after a reconstruction returns
+     * @details By default the accumulator is freed once it is converted into the returned volume, so that a
+     * reconstruction leaves only its result allocated. Keeping it saves the allocation of each scan when a batch of
+     * scans with the same geometry is reconstructed, until releaseSession() is called.
+     */
+    void setKeepSession(bool keep) {
+        keepSession = keep;
+    }
+
+    /**
+     * @brief Free the session kept from the last reconstruction
+     * @details The filter, FFT plan, geometry tables and buffers of the last reconstruction are kept in a
+     * ReconstructionSession, which is reused by the next call with the same geometry. With setKeepSession(true),
+     * the session also holds the accumulator, so that it should be released when no more scans are reconstructed.
+     */
+    void releaseSession() const {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        session = nullptr;
+    }
 
 private:
+    template <typename LoadView>
+    VolumeF32 backprojectViews(int nProj, const Geometry &geometry, const ReconstructionControl &control,
+                               uint64_t key, bool needsFilter, LoadView &&loadView) const;
+
+    template <typename LoadView>
+    VolumeF32 filterViews(int detWidth, int detHeight, int nProj, const ReconstructionControl &control,
+                          LoadView &&loadView) const;
+
+    std::shared_ptr<ReconstructionSession> acquireSession(const Geometry &geometry, int nProj) const;
+
+    void reportRoofline(const Geometry &geometry, int nViews, int nSlabs, int viewBatch, bool needsFilter,
+                        double seconds, const HostCalibration &host) const;
+
+    uint64_t checkpointKey(const char *projections, uint64_t projBytes, int nProj, const Geometry &geometry,
+                           int kind, float freeRay = 0.0f) const;
+
     RampFilter filter;
+    TuningConfig tuning;
+    int slabHeight = 0;
+    bool rooflineReport = false;
+    bool keepSession = false;
+    std::shared_ptr<ReconstructionCheckpoint> checkpoint = nullptr;
+    mutable std::shared_ptr<ReconstructionSession> session = nullptr;
+    mutable RooflineReport roofline;
+    mutable std::mutex sessionMutex;
 };
 
 #endif  // LIBCBCT_FELDKAMP_CPU_H
@@ -10,7 +10,6 @@
 #include "Common/Constants.h"
 #include "Utils/CudaUtils.h"
 #include "Utils/ImageUtils.h"
-#include "Common/ProgressBar.h"
 
 #define BLOCK_SIZE 8
 
@@ -43,7 +42,8 @@ __global__ void sliceBackProjectionKernel(int z, int i, Geometry &geometry, floa
     }
 }
 
-VolumeF32 FeldkampCUDA::reconstruct(const VolumeF32 &sinogram, const Geometry &geometry) const {
+VolumeF32 FeldkampCUDA::reconstruct(const VolumeF32 &sinogram, const Geometry &geometry,
+                                    const ReconstructionControl &control) const {
     const int detWidth = sinogram.size<0>();
     const int detHeight = sinogram.size<1>();
     const int nProj = sinogram.size<2>();
@@ -84,11 +84,12 @@ VolumeF32 FeldkampCUDA::reconstruct(const VolumeF32 &sinogram, const Geometry &g
     CUDA_CHECK(
         cufftPlanMany(&planInverse, rank, n, inembed, istride, idist, onembed, ostride, odist, CUFFT_C2R, batch));
 
-    ProgressBar pbar(nProj);
-    pbar.setDescription("RECON: ");
-    for (int i = 0; i < nProj; i++) {
+    // Cancellation stops after the current view, and the device memory is freed before the exception is thrown
+    ReconstructionMonitor monitor(control, nProj);
+    const uint64_t voxels = (uint64_t)volSize.x * volSize.y * volSize.z;
+    for (int i = 0; i < nProj && !monitor.cancelled(); i++) {
         const uint64_t ptrOffset = detWidth * detHeight * (uint64_t)i;
-        float *const imgPtr = sinogram.ptr() + ptrOffset;
+        const float *const imgPtr = sinogram.ptr() + ptrOffset;
         CUDA_CHECK(cudaMemcpy(devImg, imgPtr, sizeof(float) * detWidth * detHeight, cudaMemcpyHostToDevice));
 
         //Filter
@@ -117,7 +118,7 @@ VolumeF32 FeldkampCUDA::reconstruct(const VolumeF32 &sinogram, const Geometry &g
         }
         CUDA_SYNC_CHECK();
 
-        pbar.step();
+        monitor.step(1, voxels);
     }
 
     CUDA_CHECK(cudaMemcpy(tomogram.ptr(), devVolume, sizeof(float) * volSize.x * volSize.y * volSize.z,
@@ -132,5 +133,6 @@ VolumeF32 FeldkampCUDA::reconstruct(const VolumeF32 &sinogram, const Geometry &g
     CUDA_CHECK(cufftDestroy(planInverse));
     CUDA_SYNC_CHECK();
 
+    monitor.throwIfCancelled();
     return tomogram;
 }
@@ -14,7 +14,10 @@ public:
         , filter(filter) {
     }
     ~FeldkampCUDA() = default;
-    VolumeF32 reconstruct(const VolumeF32 &sinogram, const Geometry &geometry) const override;
+
+    using ReconstructionBase::reconstruct;
+    VolumeF32 reconstruct(const VolumeF32 &sinogram, const Geometry &geometry,
+                          const ReconstructionControl &control) const override;
 
 private:
     RampFilter filter;
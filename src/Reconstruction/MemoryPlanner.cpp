@@ -0,0 +1,228 @@
+#define LIBCBCT_API_EXPORT
+#include "MemoryPlanner.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
+#include "Common/OpenMP.h"
+
+namespace {
+
+std::string formatBytes(uint64_t bytes) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.2f GiB", (double)bytes / (1024.0 * 1024.0 * 1024.0));
+    return buf;
+}
+
+}  // namespace
+
+uint64_t MemoryPlan::peak() const {
+    uint64_t bytes = 0;
+    for (const auto &stage : stages) {
+        bytes = std::max(bytes, stage.bytes);
+    }
+    return bytes;
+}
+
+std::string MemoryPlan::report() const {
+    std::ostringstream oss;
+    oss << "Memory plan (budget: " << formatBytes(budget) << ")" << std::endl;
+    oss << "  sinogram type   : " << volumeTypeName(sinogramType) << std::endl;
+    oss << "  slab height     : " << (slabHeight == 0 ? std::string("whole volume") : std::to_string(slabHeight))
+        << std::endl;
+    oss << "  checkpoint      : " << (checkpoint ? "on" : "off") << std::endl;
+    oss << "  export buffers  : " << exportBuffers << " x " << exportBufferBytes / (1024 * 1024) << " MiB"
+        << std::endl;
+    oss << "Predicted peak memory" << std::endl;
+    for (const auto &stage : stages) {
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %-16s: %s", stage.name.c_str(), formatBytes(stage.bytes).c_str());
+        oss << line << std::endl;
+    }
+    oss << "  peak            : " << formatBytes(peak()) << (fits() ? "" : " (exceeds the budget)") << std::endl;
+    for (const auto &note : notes) {
+        oss << "Note: " << note << std::endl;
+    }
+    return oss.str();
+}
+
+bool MemoryPlan::verify(const std::vector<MemoryStageRecord> &measured, double tolerance) const {
+    bool ok = true;
+    for (const auto &stage : stages) {
+        uint64_t tracked = 0;
+        for (const MemoryStageRecord &r : measured) {
+            if (r.name == stage.name) {
+                tracked = std::max(tracked, r.trackedPeak);
+            }
+        }
+        if ((double)tracked > (double)stage.bytes * (1.0 + tolerance)) {
+            LIBCBCT_WARN("Stage %s allocated %s, more than the predicted %s", stage.name.c_str(),
+                         formatBytes(tracked).c_str(), formatBytes(stage.bytes).c_str());
+            ok = false;
+        }
+    }
+
+    for (const MemoryStageRecord &r : measured) {
+        if (budget != 0 && r.residentPeak > budget) {
+            LIBCBCT_WARN("Resident memory of stage %s reached %s, beyond the budget of %s", r.name.c_str(),
+                         formatBytes(r.residentPeak).c_str(), formatBytes(budget).c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+MemoryPlan MemoryPlanner::plan() const {
+    const uint64_t limit = budget != 0 ? budget : availableMemory();
+
+    // The export buffers are chosen independently, since the export runs after the reconstruction
+    const uint64_t kMiB = 1024 * 1024;
+    const std::pair<uint64_t, int> buffering[] = { { 64 * kMiB, 3 }, { 64 * kMiB, 2 }, { 64 * kMiB, 1 },
+                                                   { 16 * kMiB, 1 } };
+    uint64_t bufferBytes = 0;
+    int buffers = 0;
+    for (const auto &[bytes, count] : buffering) {
+        bufferBytes = bytes;
+        buffers = count;
+        const MemoryPlan p = evaluate(VolumeType::Float32, 0, false, bytes, count);
+        const auto exportStage = std::find_if(p.stages.begin(), p.stages.end(),
+                                              [](const MemoryPlan::Stage &s) { return s.name == "export"; });
+        if (exportStage->bytes <= limit) {
+            break;
+        }
+    }
+
+    const auto finalize = [&](MemoryPlan p) {
+        p.budget = limit;
+        if (checkpoint && !p.checkpoint) {
+            p.notes.push_back("Checkpoints are disabled to fit into the budget");
+        }
+        if (!p.fits()) {
+            p.notes.push_back("No settings fit into the budget, and the ones using the least memory are shown");
+        }
+        return p;
+    };
+
+    // Whole volume at once, with the sinogram in float and then in 16 bits
+    for (bool ckpt : { checkpoint, false }) {
+        for (VolumeType type : { VolumeType::Float32, VolumeType::Uint16 }) {
+            MemoryPlan p = evaluate(type, 0, ckpt, bufferBytes, buffers);
+            p.budget = limit;
+            if (p.fits()) {
+                return finalize(p);
+            }
+        }
+    }
+
+    // Slabs of decreasing height, which are multiples of the brick size
+    for (int height = (volSize.z - 1) / brickSize * brickSize; height >= brickSize; height -= brickSize) {
+        MemoryPlan p = evaluate(VolumeType::Uint16, height, false, bufferBytes, buffers);
+        p.budget = limit;
+        if (p.fits()) {
+            return finalize(p);
+        }
+    }
+
+    return finalize(evaluate(VolumeType::Uint16, std::min(brickSize, volSize.z), false, bufferBytes, buffers));
+}
+
+MemoryPlan MemoryPlanner::evaluate(VolumeType sinogramType, int slabHeight, bool checkpoint,
+                                   uint64_t exportBufferBytes, int exportBuffers) const {
+    MemoryPlan p;
+    p.sinogramType = sinogramType;
+    p.slabHeight = slabHeight >= volSize.z ? 0 : slabHeight;
+    p.checkpoint = checkpoint && p.slabHeight == 0;
+    p.exportBufferBytes = exportBufferBytes;
+    p.exportBuffers = exportBuffers;
+    p.budget = budget;
+
+    const uint64_t nThreads = omp_get_max_threads();
+    const uint64_t projPixels = (uint64_t)detSize.x * detSize.y;
+    const uint64_t sinoBytes = projPixels * nViews * volumeTypeSize(sinogramType);
+    const uint64_t volumeBytes = sizeof(float) * volSize.x * volSize.y * volSize.z;
+
+    // Decoded images held by the import threads
+    p.stages.push_back({ "import", sinoBytes + nThreads * projPixels * sizeof(uint16_t) });
+
+    // Projections held during the backprojection, the buffers of a batch of views and the scratch of the filter
+    uint64_t projBytes = sinoBytes;
+    uint64_t viewBytes = projPixels * sizeof(float) * viewBatch + projPixels * 2 * sizeof(float);
+    if (useCache) {
+        const uint64_t filteredBytes = projPixels * nViews * sizeof(float);
+        p.stages.push_back({ "filter", sinoBytes + filteredBytes + nThreads * projPixels * 2 * sizeof(float) });
+        projBytes = filteredBytes;
+        viewBytes = projPixels * sizeof(float) * viewBatch;
+    }
+
+    if (p.slabHeight == 0) {
+        const uint64_t accumBytes = accumulatorBytes(volSize.z);
+        p.stages.push_back({ "backprojection", projBytes + accumBytes + viewBytes + (p.checkpoint ? accumBytes : 0) });
+        p.stages.push_back({ "conversion", projBytes + accumBytes + volumeBytes });
+    } else {
+        p.stages.push_back({ "backprojection", projBytes + volumeBytes + accumulatorBytes(p.slabHeight) + viewBytes });
+    }
+
+    // Thread-local histograms of the statistics, and the reduced volumes of the pyramid
+    uint64_t exportBytes = volumeBytes + exportBufferBytes * exportBuffers + nThreads * 65536 * sizeof(uint64_t);
+    if (pyramidLevels > 0) {
+        exportBytes += volumeBytes / 8 + volumeBytes / 64;
+    }
+    p.stages.push_back({ "export", exportBytes });
+
+    // Bricked copy of the volume shown by the preview, made before the volume is freed
+    if (preview) {
+        p.stages.push_back({ "preview", volumeBytes + accumulatorBytes(volSize.z) });
+    }
+    return p;
+}
+
+uint64_t MemoryPlanner::accumulatorBytes(int height) const {
+    // Bricks have a power-of-two size, and the bricks at the upper boundaries are padded
+    int bs = 1;
+    while (bs < brickSize) {
+        bs <<= 1;
+    }
+    const auto padded = [bs](int size) -> uint64_t { return (uint64_t)(size + bs - 1) / bs * bs; };
+    return sizeof(float) * padded(volSize.x) * padded(volSize.y) * padded(height);
+}
+
+uint64_t MemoryPlanner::availableMemory() {
+#if defined(_WIN32)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    GlobalMemoryStatusEx(&status);
+    return (uint64_t)status.ullAvailPhys;
+#else
+    // MemAvailable includes the page cache that can be reclaimed, unlike the free pages
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    unsigned long long kiB = 0;
+    while (std::getline(meminfo, line)) {
+        if (std::sscanf(line.c_str(), "MemAvailable: %llu kB", &kiB) == 1) {
+            return (uint64_t)kiB * 1024;
+        }
+    }
+#if defined(_SC_AVPHYS_PAGES)
+    return (uint64_t)sysconf(_SC_AVPHYS_PAGES) * (uint64_t)sysconf(_SC_PAGESIZE);
+#else
+    return (uint64_t)sysconf(_SC_PHYS_PAGES) * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+#endif
+}
+
+uint64_t MemoryPlanner::peakResidentMemory() {
+    return MemoryTracker::residentPeak();
+}
@@ -0,0 +1,132 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_MEMORY_PLANNER_H
+#define LIBCBCT_MEMORY_PLANNER_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Common/Api.h"
+#include "Common/MemoryTracker.h"
+#include "Utils/Vec.h"
+#include "Utils/Volume.h"
+
+/**
+ * @brief Settings of the CPU reconstruction pipeline and their predicted peak memory per stage
+ */
+struct LIBCBCT_API MemoryPlan {
+    struct Stage {
+        std::string name;
+        uint64_t bytes;
+    };
+
+    //! Voxel type of the sinogram kept in memory (Float32, or Uint16 for the raw counts)
+    VolumeType sinogramType = VolumeType::Float32;
+    //! Number of z-slices backprojected at a time (zero for the whole volume at once)
+    int slabHeight = 0;
+    //! Whether checkpoints are taken during the backprojection
+    bool checkpoint = false;
+    //! Size and number of the conversion buffers of the RAW export
+    uint64_t exportBufferBytes = 0;
+    int exportBuffers = 0;
+
+    uint64_t budget = 0;
+    std::vector<Stage> stages;
+    std::vector<std::string> notes;
+
+    //! Largest predicted memory over the stages
+    uint64_t peak() const;
+
+    bool fits() const {
+        return peak() <= budget;
+    }
+
+    //! Human readable table of the settings and the stages
+    std::string report() const;
+
+    /**
+     * @brief Check the peaks measured by the MemoryTracker against the plan
+     * @details A stage fails when its tracked peak exceeds the predicted memory by more than the relative
+     * tolerance, and the run fails when the resident peak of a stage exceeds the budget (if any). Stages that were
+     * not measured are skipped. Each failure is logged as a warning.
+     */
+    bool verify(const std::vector<MemoryStageRecord> &measured, double tolerance = 0.1) const;
+};
+
+/**
+ * @brief Planner choosing the pipeline settings that fit into a memory budget
+ * @details The memory of each stage (import, filtering, backprojection, conversion to the linear layout and export)
+ * is predicted from the detector size, the number of views and the volume size. The planner prefers the settings of
+ * the fastest pipeline, and falls back to keeping the sinogram as 16-bit raw counts, then to backprojecting the
+ * volume in slabs of decreasing height, and shrinks the export buffers as needed.
+ */
+class LIBCBCT_API MemoryPlanner {
+public:
+    MemoryPlanner(const vec2i &detSize, int nViews, const vec3i &volSize, int brickSize = 8)
+        : detSize{ detSize }
+        , nViews{ nViews }
+        , volSize{ volSize }
+        , brickSize{ brickSize } {
+    }
+
+    //! Memory budget in bytes, where zero means the memory currently available
+    void setBudget(uint64_t bytes) {
+        budget = bytes;
+    }
+
+    //! Whether the filtered projections are cached (see FilteredProjectionCache)
+    void setUseCache(bool use) {
+        useCache = use;
+    }
+
+    //! Whether checkpoints are requested (see FeldkampCPU::setCheckpoint)
+    void setCheckpoint(bool use) {
+        checkpoint = use;
+    }
+
+    void setPyramidLevels(int levels) {
+        pyramidLevels = levels;
+    }
+
+    //! Whether the volume is shown in the preview after the export
+    void setPreview(bool show) {
+        preview = show;
+    }
+
+    //! Number of views backprojected at once (see TuningConfig)
+    void setViewBatch(int batch) {
+        viewBatch = std::max(1, batch);
+    }
+
+    //! Choose the settings within the budget, or the ones using the least memory if nothing fits
+    MemoryPlan plan() const;
+
+    //! Predict the memory of the given settings
+    MemoryPlan evaluate(VolumeType sinogramType, int slabHeight, bool checkpoint, uint64_t exportBufferBytes,
+                        int exportBuffers) const;
+
+    //! Physical memory currently available to the process
+    static uint64_t availableMemory();
+
+    //! Peak resident memory of the process so far (VmHWM on Linux), or zero if unknown
+    static uint64_t peakResidentMemory();
+
+private:
+    uint64_t accumulatorBytes(int height) const;
+
+    vec2i detSize;
+    int nViews;
+    vec3i volSize;
+    int brickSize;
+    uint64_t budget = 0;
+    bool useCache = false;
+    bool checkpoint = false;
+    int pyramidLevels = 0;
+    bool preview = false;
+    int viewBatch = 1;
+};
+
+#endif  // LIBCBCT_MEMORY_PLANNER_H
@@ -5,7 +5,16 @@
 #ifndef LIBCBCT_RECONSTRUCTION_BASE_H
 #define LIBCBCT_RECONSTRUCTION_BASE_H
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
 #include "Common/Api.h"
+#include "Common/ProgressBar.h"
 #include "Utils/Volume.h"
 #include "Geometry/GeometryBase.h"
 
@@ -14,6 +23,150 @@ enum class RampFilter : int {
     SheppLogan,
 };
 
+//! Progress of a reconstruction passed to the progress callback
+struct ReconstructionProgress {
+    int viewsDone = 0;                 // Views backprojected (or filtered) so far
+    int totalViews = 0;                // With slabs, each view is counted once per slab
+    double voxelUpdatesPerSec = 0.0;   // Average over the elapsed time
+    double elapsedSec = 0.0;
+    double etaSec = 0.0;               // Estimated remaining time
+};
+
+using ProgressCallback = std::function<void(const ReconstructionProgress &)>;
+
+/**
+ * @brief Shared flag to cancel a running reconstruction
+ * @details Copies of a token share the same flag, so that a copy passed to the reconstruction is cancelled by
+ * calling cancel() on the original.
+ */
+class CancellationToken {
+public:
+    CancellationToken()
+        : flag{ std::make_shared<std::atomic<bool>>(false) } {
+    }
+
+    void cancel() const {
+        flag->store(true, std::memory_order_relaxed);
+    }
+
+    bool cancelled() const {
+        return flag->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+//! Exception thrown by a reconstruction cancelled with its token
+class ReconstructionCancelled : public std::runtime_error {
+public:
+    ReconstructionCancelled()
+        : std::runtime_error("Reconstruction cancelled") {
+    }
+};
+
+/**
+ * @brief Per-call control of a reconstruction. Without the callback, the progress is printed to the console.
+ * @details The callback is called from the thread that invoked the reconstruction, at most every
+ * ProgressBar::kRefreshInterval and once more when all the views are done, never from the OpenMP workers.
+ */
+struct ReconstructionControl {
+    CancellationToken token;
+    ProgressCallback progress = nullptr;
+
+    //! Control printing nothing, e.g., for the timed runs of the benchmarks and the tuner
+    static ReconstructionControl silent() {
+        ReconstructionControl control;
+        control.progress = [](const ReconstructionProgress &) {};
+        return control;
+    }
+};
+
+/**
+ * @brief Progress reporting and cancellation used inside the reconstruction loops
+ * @details step() is called after each batch of views (possibly from several threads) and only counts them in
+ * atomics, as ProgressBar::step() does. The progress is passed to the callback of the control by the thread that
+ * created the monitor, rate-limited to ProgressBar::kRefreshInterval, and finish() reports the final count after a
+ * parallel loop. Without a callback, a console progress bar is stepped instead. Cancellation is checked between the
+ * batches, and the loops stop by throwIfCancelled(), or by cancelled() where the work must be cleaned up first (e.g.,
+ * in parallel regions, which cannot be left by an exception).
+ */
+class ReconstructionMonitor {
+public:
+    ReconstructionMonitor(const ReconstructionControl &control, int totalViews, const char *description = "RECON: ")
+        : control{ control }
+        , totalViews{ totalViews }
+        , start{ std::chrono::steady_clock::now() } {
+        if (!control.progress) {
+            pbar = std::make_unique<ProgressBar>(totalViews);
+            pbar->setDescription(description);
+        }
+    }
+
+    //! Report n more views done, which updated the given number of voxels
+    void step(int n = 1, uint64_t voxelUpdates = 0) {
+        if (pbar) {
+            pbar->step(n);
+            return;
+        }
+
+        const int done = viewsDone.fetch_add(n, std::memory_order_relaxed) + n;
+        updates.fetch_add(voxelUpdates, std::memory_order_relaxed);
+        if (std::this_thread::get_id() != owner) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (done >= totalViews || now - lastReport >= ProgressBar::kRefreshInterval) {
+            report(now);
+        }
+    }
+
+    //! Report the final count, which is called by the creating thread after the views were stepped in parallel
+    void finish() {
+        if (!pbar && reportedViews != viewsDone.load(std::memory_order_relaxed)) {
+            report(std::chrono::steady_clock::now());
+        }
+    }
+
+    bool cancelled() const {
+        return control.token.cancelled();
+    }
+
+    void throwIfCancelled() const {
+        if (cancelled()) {
+            throw ReconstructionCancelled();
+        }
+    }
+
+private:
+    void report(std::chrono::steady_clock::time_point now) {
+        ReconstructionProgress progress;
+        progress.viewsDone = viewsDone.load(std::memory_order_relaxed);
+        progress.totalViews = totalViews;
+        progress.elapsedSec = std::chrono::duration<double>(now - start).count();
+        progress.voxelUpdatesPerSec =
+            progress.elapsedSec > 0.0 ? (double)updates.load(std::memory_order_relaxed) / progress.elapsedSec : 0.0;
+        progress.etaSec = progress.viewsDone > 0
+                              ? progress.elapsedSec / progress.viewsDone * (totalViews - progress.viewsDone)
+                              : 0.0;
+        lastReport = now;
+        reportedViews = progress.viewsDone;
+        control.progress(progress);
+    }
+
+    const ReconstructionControl &control;
+    int totalViews;
+    std::atomic<int> viewsDone{ 0 };
+    std::atomic<uint64_t> updates{ 0 };
+    std::chrono::steady_clock::time_point start;
+    std::unique_ptr<ProgressBar> pbar = nullptr;
+
+    // Used only by the creating thread, which calls the callback
+    std::thread::id owner = std::this_thread::get_id();
+    std::chrono::steady_clock::time_point lastReport;
+    int reportedViews = 0;
+};
+
 /**
  * @brief Interface class for CT reconstruction
  */
@@ -21,7 +174,32 @@ class LIBCBCT_API ReconstructionBase {
 public:
     ReconstructionBase() = default;
     virtual ~ReconstructionBase() = default;
-    virtual VolumeF32 reconstruct(const VolumeF32 &sinogram, const Geometry &geometry) const = 0;
+
+    VolumeF32 reconstruct(const VolumeF32 &sinogram, const Geometry &geometry) const {
+        return reconstruct(sinogram, geometry, ReconstructionControl());
+    }
+
+    /**
+     * @brief Reconstruct with a cancellation token and a progress callback
+     * @details A cancelled reconstruction throws ReconstructionCancelled.
+     */
+    virtual VolumeF32 reconstruct(const VolumeF32 &sinogram, const Geometry &geometry,
+                                  const ReconstructionControl &control) const = 0;
+
+    /**
+     * @brief Reconstruct in a background thread
+     * @details The sinogram is moved into the task (pass it with std::move to avoid the copy), and the reconstructor
+     * must outlive the returned future. The progress callback is called from the background thread running the
+     * reconstruction (see ReconstructionControl), and a cancelled reconstruction stores ReconstructionCancelled in
+     * the future.
+     */
+    std::future<VolumeF32> reconstructAsync(VolumeF32 sinogram, const Geometry &geometry,
+                                            ReconstructionControl control = ReconstructionControl()) const {
+        return std::async(std::launch::async,
+                          [this, sinogram = std::move(sinogram), geometry, control = std::move(control)]() {
+                              return reconstruct(sinogram, geometry, control);
+                          });
+    }
 
 protected:
 };
@@ -0,0 +1,158 @@
+#define LIBCBCT_API_EXPORT
+#include "ReconstructionCheckpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Common/Logging.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+//! Flush the data of a file to the disk, so that it is not lost in a crash of the node after the rename
+bool syncFile(std::FILE *file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+//! Flush the directory holding a renamed file, so that the rename itself is durable (no-op on Windows)
+void syncDirectory(const fs::path &dir) {
+#if !defined(_WIN32)
+    const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#endif
+}
+
+}  // namespace
+
+ReconstructionCheckpoint::ReconstructionCheckpoint(const std::string &filename, int interval, bool resume)
+    : filename{ filename }
+    , interval{ interval }
+    , resume{ resume } {
+    LIBCBCT_ASSERT(interval > 0, "Checkpoint interval must be positive!");
+}
+
+ReconstructionCheckpoint::~ReconstructionCheckpoint() {
+    wait();
+}
+
+int ReconstructionCheckpoint::restore(uint64_t key, BrickedVolumeF32 &accum) {
+    // A cancelled run may still be writing its last checkpoint
+    std::lock_guard<std::mutex> lock(mutex);
+    wait();
+    if (!resume || !fs::exists(filename)) {
+        return 0;
+    }
+
+    std::ifstream reader(filename.c_str(), std::ios::in | std::ios::binary);
+    char magic[8];
+    uint32_t version, nextView;
+    uint64_t storedKey, bytes;
+    reader.read(magic, 8);
+    reader.read(reinterpret_cast<char *>(&version), 4);
+    reader.read(reinterpret_cast<char *>(&nextView), 4);
+    reader.read(reinterpret_cast<char *>(&storedKey), 8);
+    reader.read(reinterpret_cast<char *>(&bytes), 8);
+    if (reader.fail() || std::memcmp(magic, kMagic, 8) != 0 || version != kVersion) {
+        LIBCBCT_WARN("Broken checkpoint is ignored: %s", filename.c_str());
+        return 0;
+    }
+    if (storedKey != key || bytes != sizeof(float) * accum.numBricks() * accum.brickVoxels()) {
+        LIBCBCT_WARN("Checkpoint of another reconstruction is ignored: %s", filename.c_str());
+        return 0;
+    }
+
+    reader.read(reinterpret_cast<char *>(accum.ptr()), bytes);
+    if (reader.fail()) {
+        // The data may be missing after a crash of the node, like a broken header
+        LIBCBCT_WARN("Truncated checkpoint is ignored: %s", filename.c_str());
+        accum.clear();
+        return 0;
+    }
+    LIBCBCT_INFO("Resume from view #%u: %s", nextView, filename.c_str());
+    return (int)nextView;
+}
+
+void ReconstructionCheckpoint::save(uint64_t key, const BrickedVolumeF32 &accum, int nextView) {
+    if (nextView % interval != 0) {
+        return;
+    }
+
+    // The snapshot is reused, so that the previous write must be completed before it is overwritten
+    std::lock_guard<std::mutex> lock(mutex);
+    wait();
+    const uint64_t count = (uint64_t)accum.numBricks() * accum.brickVoxels();
+    if (snapshotSize != count) {
+        snapshot = std::make_unique<float[]>(count);
+        snapshotSize = count;
+    }
+    std::memcpy(snapshot.get(), accum.ptr(), sizeof(float) * count);
+
+    writer = std::thread([this, key, nextView] {
+        const std::string tempName = filename + ".tmp";
+        std::FILE *file = std::fopen(tempName.c_str(), "wb");
+        if (file == nullptr) {
+            LIBCBCT_ERROR("Failed to open file: %s", tempName.c_str());
+        }
+
+        const uint32_t version = kVersion;
+        const uint32_t view = (uint32_t)nextView;
+        const uint64_t bytes = sizeof(float) * snapshotSize;
+        bool ok = true;
+        const auto put = [&](const void *data, uint64_t size) {
+            ok = ok && std::fwrite(data, 1, size, file) == size;
+        };
+        put(kMagic, 8);
+        put(&version, 4);
+        put(&view, 4);
+        put(&key, 8);
+        put(&bytes, 8);
+        put(snapshot.get(), bytes);
+        ok = ok && syncFile(file);
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) {
+            LIBCBCT_ERROR("Failed to write file: %s", tempName.c_str());
+        }
+
+        std::error_code ec;
+        fs::rename(tempName, filename, ec);
+        if (ec) {
+            LIBCBCT_ERROR("Failed to rename %s to %s", tempName.c_str(), filename.c_str());
+        }
+        syncDirectory(fs::path(filename).parent_path());
+    });
+}
+
+void ReconstructionCheckpoint::finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    wait();
+    std::error_code ec;
+    fs::remove(filename, ec);
+    snapshot.reset();
+    snapshotSize = 0;
+}
+
+void ReconstructionCheckpoint::wait() {
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
@@ -0,0 +1,100 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_RECONSTRUCTION_CHECKPOINT_H
+#define LIBCBCT_RECONSTRUCTION_CHECKPOINT_H
+
+#include <atomic>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <stdexcept>
+
+#include "Common/Api.h"
+#include "Utils/BrickedVolume.h"
+
+/**
+ * @brief Periodic checkpoint of the partial backprojection
+ * @details A checkpoint holds the accumulated volume after a number of views, together with the index of the next
+ * view and a key identifying the reconstruction (inputs, geometry and settings). Saving copies the accumulator into a
+ * snapshot buffer and writes it from a background thread to a temporary file, which then replaces the checkpoint,
+ * so that the reconstruction is stalled only by the copy and a preemption never leaves a torn checkpoint. The
+ * temporary file is flushed to the disk before it is renamed, and a checkpoint whose data is still shorter than its
+ * header says is ignored. The snapshot buffer is as large as the accumulator.
+ *
+ *     char[8]    magic ("CBCTCKPT")
+ *     uint32     version
+ *     uint32     next view
+ *     uint64     key
+ *     uint64     number of accumulator bytes
+ *     accumulator in the bricked layout
+ */
+class LIBCBCT_API ReconstructionCheckpoint {
+public:
+    /**
+     * @brief Exclusive use of the checkpoint by a reconstruction
+     * @details A checkpoint holds the snapshot and the file of a single run, so that a second reconstruction taking
+     * it while the first one is running throws std::runtime_error rather than overwriting them.
+     */
+    class Lease {
+    public:
+        explicit Lease(ReconstructionCheckpoint *checkpoint)
+            : checkpoint{ checkpoint } {
+            if (checkpoint && checkpoint->inUse.exchange(true)) {
+                throw std::runtime_error("Checkpoint is in use by another reconstruction: " + checkpoint->filename);
+            }
+        }
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        ~Lease() {
+            if (checkpoint) {
+                checkpoint->inUse.store(false);
+            }
+        }
+
+    private:
+        ReconstructionCheckpoint *checkpoint;
+    };
+
+    ReconstructionCheckpoint(const std::string &filename, int interval, bool resume = true);
+    ReconstructionCheckpoint(const ReconstructionCheckpoint &) = delete;
+    ReconstructionCheckpoint &operator=(const ReconstructionCheckpoint &) = delete;
+    virtual ~ReconstructionCheckpoint();
+
+    /**
+     * @brief Restore the accumulator from the checkpoint with the given key, after the pending save completes
+     * @return Index of the view to continue from, or zero if there is nothing to resume
+     */
+    int restore(uint64_t key, BrickedVolumeF32 &accum);
+
+    //! Save the accumulator after the views [0, nextView) in the background, if nextView is on the interval
+    void save(uint64_t key, const BrickedVolumeF32 &accum, int nextView);
+
+    //! Number of views between the checkpoints
+    int saveInterval() const {
+        return interval;
+    }
+
+    //! Wait for the pending save and delete the checkpoint, which is called after the reconstruction completes
+    void finish();
+
+private:
+    static constexpr char kMagic[8] = { 'C', 'B', 'C', 'T', 'C', 'K', 'P', 'T' };
+    static constexpr uint32_t kVersion = 1;
+
+    void wait();
+
+    std::string filename;
+    int interval;
+    bool resume;
+    std::unique_ptr<float[]> snapshot = nullptr;
+    uint64_t snapshotSize = 0;
+    std::thread writer;
+    std::mutex mutex;
+    std::atomic<bool> inUse{ false };
+};
+
+#endif  // LIBCBCT_RECONSTRUCTION_CHECKPOINT_H
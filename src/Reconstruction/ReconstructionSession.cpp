@@ -0,0 +1,272 @@
+#define LIBCBCT_API_EXPORT
+#include "ReconstructionSession.h"
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "Common/Constants.h"
+#include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
+#include "Common/OpenMP.h"
+#include "Common/Parallel.h"
+#include "Common/PerfCounters.h"
+#include "Common/Trace.h"
+#include "Utils/ImageUtils.h"
+
+#include "pocketfft_hdronly.h"
+
+namespace pfft = pocketfft;
+
+namespace {
+
+constexpr std::size_t kAlignment = 64;
+
+#if defined(POCKETFFT_NO_VECTORS)
+constexpr int kLanes = 1;
+#else
+constexpr int kLanes = (int)pfft::detail::VLEN<float>::val;
+#endif
+
+//! Scratch of the reconstruction, which is counted by the MemoryTracker
+float *allocAligned(uint64_t count) {
+    MemoryTracker::allocate(MemoryCategory::Scratch, sizeof(float) * count);
+    return static_cast<float *>(::operator new[](sizeof(float) * count, std::align_val_t(kAlignment)));
+}
+
+void freeAligned(float *ptr, uint64_t count) {
+    if (ptr != nullptr) {
+        ::operator delete[](ptr, std::align_val_t(kAlignment));
+        MemoryTracker::release(MemoryCategory::Scratch, sizeof(float) * count);
+    }
+}
+
+std::vector<float> rampFilterKernel(RampFilter filter, int detWidth) {
+    std::vector<float> H(detWidth);
+    for (int x = 0; x < detWidth; x++) {
+        const float q = std::min(x, detWidth - x) / (0.5f * detWidth);
+        if (filter == RampFilter::RamLak) {
+            H[x] = std::abs(q);
+        } else if (filter == RampFilter::SheppLogan) {
+            H[x] = (2.0f * (float)libcbct::kOneOverPi) * std::abs(std ::sin((float)libcbct::kHalfPi * q));
+        } else {
+            LIBCBCT_ERROR("Unknown ramp filter specified!");
+        }
+    }
+    return H;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+// ProjectionFilter
+// -----------------------------------------------------------------------------
+
+struct ProjectionFilter::Plan {
+    explicit Plan(int length)
+        : fft(length) {
+    }
+
+    pfft::detail::pocketfft_r<float> fft;
+};
+
+ProjectionFilter::ProjectionFilter(RampFilter filter, int detWidth, int detHeight)
+    : filter{ filter }
+    , detWidth{ detWidth }
+    , detHeight{ detHeight }
+    , H{ rampFilterKernel(filter, detWidth) }
+    , plan{ std::make_unique<Plan>(detWidth) } {
+    // Scratch of each thread holds kLanes rows interleaved, padded to the alignment
+    const uint64_t lineFloats = kAlignment / sizeof(float);
+    scratchSize = ((uint64_t)detWidth * kLanes + lineFloats - 1) / lineFloats * lineFloats;
+    numScratches = omp_get_max_threads();
+    arena = allocAligned(scratchSize * numScratches);
+}
+
+ProjectionFilter::~ProjectionFilter() {
+    freeAligned(arena, scratchSize * numScratches);
+}
+
+void ProjectionFilter::apply(float *proj, int thread) const {
+    LIBCBCT_TRACE_SCOPE("filter");
+    if (thread >= 0) {
+        LIBCBCT_ASSERT(thread < numScratches, "Thread index exceeds the number of scratch buffers!");
+        filterRows(proj, 0, detHeight, arena + scratchSize * thread);
+        return;
+    }
+
+    // Threads beyond those the scratch buffers were allocated for would write past the arena
+    const ScopedThreadCount threads(std::min(omp_get_max_threads(), numScratches));
+    LIBCBCT_PERF_REGION("filter", 0);
+    const int nGroups = (detHeight + kLanes - 1) / kLanes;
+    OMP_PARALLEL_FOR(int g = 0; g < nGroups; g++) {
+        const int yBegin = g * kLanes;
+        const int yEnd = std::min(detHeight, yBegin + kLanes);
+        filterRows(proj, yBegin, yEnd, arena + scratchSize * omp_get_thread_num());
+    }
+}
+
+void ProjectionFilter::filterRows(float *proj, int yBegin, int yEnd, float *scratch) const {
+    // In the half-complex order, the element x > 0 is the real or imaginary part of the frequency (x + 1) / 2
+    const float fct = 1.0f / detWidth;
+    int y = yBegin;
+#if !defined(POCKETFFT_NO_VECTORS)
+    using vfloat = pfft::detail::vtype_t<float>;
+    vfloat *const lanes = reinterpret_cast<vfloat *>(scratch);
+    for (; y + kLanes <= yEnd; y += kLanes) {
+        for (int x = 0; x < detWidth; x++) {
+            for (int j = 0; j < kLanes; j++) {
+                lanes[x][j] = proj[(uint64_t)(y + j) * detWidth + x];
+            }
+        }
+        plan->fft.exec(lanes, 1.0f, true);
+        for (int x = 0; x < detWidth; x++) {
+            lanes[x] *= H[(x + 1) / 2];
+        }
+        plan->fft.exec(lanes, fct, false);
+        for (int x = 0; x < detWidth; x++) {
+            for (int j = 0; j < kLanes; j++) {
+                proj[(uint64_t)(y + j) * detWidth + x] = lanes[x][j];
+            }
+        }
+    }
+#endif
+    for (; y < yEnd; y++) {
+        float *const row = proj + (uint64_t)y * detWidth;
+        plan->fft.exec(row, 1.0f, true);
+        for (int x = 0; x < detWidth; x++) {
+            row[x] *= H[(x + 1) / 2];
+        }
+        plan->fft.exec(row, fct, false);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// ReconstructionSession
+// -----------------------------------------------------------------------------
+
+ReconstructionSession::ReconstructionSession(const Geometry &geometry, int nProj, RampFilter filter, int brickSize,
+                                             int viewBatch)
+    : geom{ geometry }
+    , nProj{ nProj }
+    , brickSize{ brickSize }
+    , viewBatch{ std::max(1, viewBatch) }
+    , filter{ filter, geometry.detSize.x, geometry.detSize.y } {
+    cosTheta.resize(nProj);
+    sinTheta.resize(nProj);
+    for (int i = 0; i < nProj; i++) {
+        const float theta = (float)libcbct::kTwoPi * i / nProj;
+        cosTheta[i] = cosf(theta);
+        sinTheta[i] = sinf(theta);
+    }
+
+    // Same as the voxel-to-world transform in vox2pix()
+    const float vs = voxelSize(geom);
+    const auto axisTable = [vs](std::vector<float> &table, int size) {
+        const float center = size * 0.5f;
+        table.resize(size);
+        for (int i = 0; i < size; i++) {
+            table[i] = ((float)i - center) * vs;
+        }
+    };
+    axisTable(worldX, geom.volSize.x);
+    axisTable(worldY, geom.volSize.y);
+    axisTable(worldZ, geom.volSize.z);
+
+    viewBuf = allocAligned((uint64_t)geom.detSize.x * geom.detSize.y * this->viewBatch);
+}
+
+ReconstructionSession::~ReconstructionSession() {
+    freeAligned(viewBuf, (uint64_t)geom.detSize.x * geom.detSize.y * viewBatch);
+}
+
+bool ReconstructionSession::matches(const Geometry &geometry, int nProj, RampFilter filter, int brickSize,
+                                    int viewBatch) const {
+    return geometry.detSize.x == geom.detSize.x && geometry.detSize.y == geom.detSize.y &&
+           geometry.pixSize.x == geom.pixSize.x && geometry.pixSize.y == geom.pixSize.y &&
+           geometry.volSize.x == geom.volSize.x && geometry.volSize.y == geom.volSize.y &&
+           geometry.volSize.z == geom.volSize.z && geometry.sod == geom.sod && geometry.sdd == geom.sdd &&
+           nProj == this->nProj && filter == this->filter.type() && brickSize == this->brickSize &&
+           std::max(1, viewBatch) == this->viewBatch && omp_get_max_threads() <= this->filter.numThreads();
+}
+
+void ReconstructionSession::backprojectView(BrickedVolumeF32 &accum, const float *filtered, int i,
+                                            int zOffset) const {
+    backprojectViews(accum, &filtered, i, 1, zOffset);
+}
+
+void ReconstructionSession::backprojectViews(BrickedVolumeF32 &accum, const float *const *filtered, int first,
+                                             int count, int zOffset) const {
+    LIBCBCT_TRACE_SCOPE("backproject");
+    const int detWidth = geom.detSize.x;
+    const int detHeight = geom.detSize.y;
+    const int sx = accum.size<0>();
+    const int sy = accum.size<1>();
+    const int sz = accum.size<2>();
+    const int bs = accum.brickSize();
+    LIBCBCT_ASSERT(sx == geom.volSize.x && sy == geom.volSize.y && zOffset >= 0 && zOffset + sz <= geom.volSize.z,
+                   "Accumulator size does not match the session!");
+    LIBCBCT_ASSERT(first >= 0 && count > 0 && first + count <= nProj, "View batch out of range!");
+    LIBCBCT_PERF_REGION("backproject", (uint64_t)sx * sy * sz * count);
+
+    const float *const cosT = cosTheta.data() + first;
+    const float *const sinT = sinTheta.data() + first;
+    OMP_PARALLEL_FOR(int b = 0; b < accum.numBricks(); b++) {
+        const vec3i org = accum.brickOrigin(b);
+        const int nx = std::min(bs, sx - org.x);
+        const int ny = std::min(bs, sy - org.y);
+        const int nz = std::min(bs, sz - org.z);
+        float *const brick = accum.brickPtr(b);
+        for (int z = 0; z < nz; z++) {
+            const float wz = worldZ[zOffset + org.z + z];
+            for (int y = 0; y < ny; y++) {
+                const float wy = worldY[org.y + y];
+                float *const row = brick + (z * bs + y) * bs;
+                for (int x = 0; x < nx; x++) {
+                    const vec3f xyz(worldX[org.x + x], wy, wz);
+                    float sum = row[x];
+                    for (int j = 0; j < count; j++) {
+                        const vec3f uvw = project(xyz, cosT[j], sinT[j], geom);
+                        if (uvw.x >= 0 && uvw.y >= 0 && uvw.x < detWidth && uvw.y < detHeight) {
+                            sum += bilerp(filtered[j], detWidth, detHeight, uvw.x - 0.5f, uvw.y - 0.5f) * uvw.z / nProj;
+                        }
+                    }
+                    row[x] = sum;
+                }
+            }
+        }
+    }
+}
+
+BrickedVolumeF32 &ReconstructionSession::accumulator(int height) {
+    if (accum.size<0>() != (uint64_t)geom.volSize.x || accum.size<1>() != (uint64_t)geom.volSize.y ||
+        accum.size<2>() != (uint64_t)height || accum.brickSize() != brickSize) {
+        accum.resize(geom.volSize.x, geom.volSize.y, height, brickSize);
+    } else {
+        accum.clear();
+    }
+    return accum;
+}
+
+void ReconstructionSession::release() {
+    accum = BrickedVolumeF32();
+}
+
+void ReconstructionSession::loadView(const VolumeF32 &sinogram, int i, float *out) {
+    const uint64_t projSize = sinogram.size<0>() * sinogram.size<1>();
+    const float *const ptr = sinogram.ptr() + projSize * i;
+    for (uint64_t k = 0; k < projSize; k++) {
+        out[k] = ptr[k];
+    }
+}
+
+void ReconstructionSession::loadView(const VolumeU16 &counts, float freeRay, int i, float *out) {
+    LIBCBCT_TRACE_SCOPE("log transform");
+    const uint64_t projSize = counts.size<0>() * counts.size<1>();
+    const uint16_t *const ptr = counts.ptr() + projSize * i;
+    for (uint64_t k = 0; k < projSize; k++) {
+        out[k] = -std::log(((float)ptr[k] + 1.0f) / freeRay);
+    }
+}
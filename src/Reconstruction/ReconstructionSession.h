@@ -0,0 +1,145 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_RECONSTRUCTION_SESSION_H
+#define LIBCBCT_RECONSTRUCTION_SESSION_H
+
+#include <memory>
+#include <vector>
+
+#include "ReconstructionBase.h"
+#include "Utils/BrickedVolume.h"
+
+/**
+ * @brief Ramp filter along the detector rows with a precomputed kernel and FFT plan
+ * @details The rows are transformed in place in the half-complex order of the real FFT, so that no complex buffer
+ * is needed, and several rows are transformed at once in the SIMD lanes. Each thread has its own scratch buffer in
+ * an aligned arena allocated up front. The result is bit-identical to the complex r2c/c2r transforms.
+ */
+class LIBCBCT_API ProjectionFilter {
+public:
+    ProjectionFilter(RampFilter filter, int detWidth, int detHeight);
+    ProjectionFilter(const ProjectionFilter &) = delete;
+    ProjectionFilter &operator=(const ProjectionFilter &) = delete;
+    virtual ~ProjectionFilter();
+
+    /**
+     * @brief Filter a projection of detWidth x detHeight pixels in place
+     * @details By default the rows are filtered in parallel. With a thread index, the calling thread filters all
+     * the rows with the scratch buffer of that index, which is for the loops running in parallel over projections.
+     * The rows are filtered by at most numThreads() threads, even if more OpenMP threads are available.
+     */
+    void apply(float *proj, int thread = -1) const;
+
+    RampFilter type() const {
+        return filter;
+    }
+
+    int width() const {
+        return detWidth;
+    }
+
+    int height() const {
+        return detHeight;
+    }
+
+    //! Number of scratch buffers, which is the number of OpenMP threads at the construction
+    int numThreads() const {
+        return numScratches;
+    }
+
+private:
+    struct Plan;
+
+    void filterRows(float *proj, int yBegin, int yEnd, float *scratch) const;
+
+    RampFilter filter;
+    int detWidth;
+    int detHeight;
+    std::vector<float> H;
+    std::unique_ptr<Plan> plan;
+    float *arena = nullptr;
+    uint64_t scratchSize = 0;
+    int numScratches = 0;
+};
+
+/**
+ * @brief State of the FDK reconstruction reused across scans with the same geometry
+ * @details The session owns everything that depends only on the geometry and the number of views: the ramp filter
+ * with its FFT plan, the cosine and sine of each view angle, the world coordinates of the voxels along each axis,
+ * the scratch buffers of a batch of projections and the bricked accumulator. FeldkampCPU runs its view loop on a
+ * session, and reconstructing another scan with matching geometry allocates nothing but the accumulator (unless it is
+ * kept, see FeldkampCPU::setKeepSession()) and the returned volume. The tables give the same values as vox2pix(), so
+ * that the result is bit-identical to the per-voxel projection. A session must not be used by several threads at
+ * once.
+ */
+class LIBCBCT_API ReconstructionSession {
+public:
+    ReconstructionSession(const Geometry &geometry, int nProj, RampFilter filter = RampFilter::SheppLogan,
+                          int brickSize = 8, int viewBatch = 1);
+    ReconstructionSession(const ReconstructionSession &) = delete;
+    ReconstructionSession &operator=(const ReconstructionSession &) = delete;
+    virtual ~ReconstructionSession();
+
+    //! Whether the session can reconstruct the scans with the given settings and the current number of threads
+    bool matches(const Geometry &geometry, int nProj, RampFilter filter, int brickSize, int viewBatch = 1) const;
+
+    //! Accumulate the backprojection of the filtered view #i into the slab starting from the slice zOffset
+    void backprojectView(BrickedVolumeF32 &accum, const float *filtered, int i, int zOffset = 0) const;
+
+    /**
+     * @brief Accumulate the filtered views #first, ..., #first + count - 1 in a single pass over the accumulator
+     * @details Each voxel is read and written once per batch instead of once per view, and the views are added in
+     * order, so that the result is bit-identical to that of backprojecting them one by one.
+     */
+    void backprojectViews(BrickedVolumeF32 &accum, const float *const *filtered, int first, int count,
+                          int zOffset = 0) const;
+
+    //! Accumulator of the given number of slices, which is cleared and reallocated only when its size changes
+    BrickedVolumeF32 &accumulator(int height);
+
+    //! Free the accumulator, keeping the tables
+    void release();
+
+    const ProjectionFilter &projectionFilter() const {
+        return filter;
+    }
+
+    //! Scratch buffer of the projection #j of a batch
+    float *viewBuffer(int j = 0) const {
+        return viewBuf + (uint64_t)geom.detSize.x * geom.detSize.y * j;
+    }
+
+    //! Number of views backprojected at once
+    int viewBatchSize() const {
+        return viewBatch;
+    }
+
+    const Geometry &geometry() const {
+        return geom;
+    }
+
+    int numViews() const {
+        return nProj;
+    }
+
+    //! Copy the projection #i of the sinogram into the buffer
+    static void loadView(const VolumeF32 &sinogram, int i, float *out);
+
+    //! Log-transform the raw counts of the projection #i into the buffer
+    static void loadView(const VolumeU16 &counts, float freeRay, int i, float *out);
+
+private:
+    Geometry geom;
+    int nProj;
+    int brickSize;
+    int viewBatch;
+    ProjectionFilter filter;
+    std::vector<float> cosTheta, sinTheta;
+    std::vector<float> worldX, worldY, worldZ;
+    float *viewBuf = nullptr;
+    BrickedVolumeF32 accum;
+};
+
+#endif  // LIBCBCT_RECONSTRUCTION_SESSION_H
@@ -0,0 +1,389 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_BRICKED_VOLUME_H
+#define LIBCBCT_BRICKED_VOLUME_H
+
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+#include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
+#include "Common/OpenMP.h"
+#include "Utils/Vec.h"
+#include "Utils/Volume.h"
+
+/**
+ * @brief Interleave the lower 21 bits of three integers into a 63-bit Morton code
+ */
+inline uint64_t mortonEncode3(uint32_t x, uint32_t y, uint32_t z) {
+    const auto spread = [](uint64_t v) -> uint64_t {
+        v &= 0x1fffff;
+        v = (v | (v << 32)) & 0x1f00000000ffffull;
+        v = (v | (v << 16)) & 0x1f0000ff0000ffull;
+        v = (v | (v << 8)) & 0x100f00f00f00f00full;
+        v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+        v = (v | (v << 2)) & 0x1249249249249249ull;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+}
+
+/**
+ * @brief Volume stored as cubic bricks laid out in Morton order
+ * @details Voxels inside a brick are stored x-fastest, and the bricks themselves are ordered along a Z-order curve.
+ * Neighboring voxels in any direction are therefore close in memory, so that the backprojection and the
+ * orthogonal slicing along any axis touch a bounded number of cache lines and pages. Voxels in the padding of the
+ * boundary bricks are kept at zero.
+ */
+template <typename T>
+class BrickedVolume {
+public:
+    explicit BrickedVolume(int sizeX = 0, int sizeY = 0, int sizeZ = 0, int brickSize = 8) {
+        resize(sizeX, sizeY, sizeZ, brickSize);
+    }
+
+    explicit BrickedVolume(const Volume<T> &volume, int brickSize = 8)
+        : BrickedVolume(volume.template size<0>(), volume.template size<1>(), volume.template size<2>(), brickSize) {
+        copyFrom(volume);
+    }
+
+    BrickedVolume(const BrickedVolume<T> &other) {
+        *this = other;
+    }
+
+    BrickedVolume(BrickedVolume<T> &&other) {
+        *this = std::move(other);
+    }
+
+    virtual ~BrickedVolume() = default;
+
+    BrickedVolume &operator=(const BrickedVolume<T> &other) {
+        if (this == &other) {
+            return *this;
+        }
+        resize(other.sizeX, other.sizeY, other.sizeZ, other.brickSize());
+        if (data) {
+            std::memcpy(data.get(), other.data.get(), sizeof(T) * numBricks() * brickVoxels());
+        }
+        return *this;
+    }
+
+    BrickedVolume &operator=(BrickedVolume<T> &&other) {
+        if (this == &other) {
+            return *this;
+        }
+        sizeX = other.sizeX;
+        sizeY = other.sizeY;
+        sizeZ = other.sizeZ;
+        brickBits = other.brickBits;
+        std::copy_n(other.brickCounts, 3, brickCounts);
+        brickIndices = std::move(other.brickIndices);
+        brickSlots = std::move(other.brickSlots);
+        data = std::move(other.data);
+
+        other.resize(0, 0, 0);
+        return *this;
+    }
+
+    T &operator()(int x, int y, int z) {
+        LIBCBCT_ASSERT(x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ,
+                       "Volume index out of bounds!");
+        return data[offset(x, y, z)];
+    }
+
+    T operator()(int x, int y, int z) const {
+        LIBCBCT_ASSERT(x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ,
+                       "Volume index out of bounds!");
+        return data[offset(x, y, z)];
+    }
+
+    T *ptr() const {
+        return data.get();
+    }
+
+    //! Pointer to the first voxel of the brick at the given position in Morton order
+    T *brickPtr(int brick) const {
+        return data.get() + (uint64_t)brick * brickVoxels();
+    }
+
+    //! Voxel coordinates of the first voxel of the brick at the given position in Morton order
+    vec3i brickOrigin(int brick) const {
+        const uint32_t index = brickIndices[brick];
+        const int bx = index % brickCounts[0];
+        const int by = (index / brickCounts[0]) % brickCounts[1];
+        const int bz = index / (brickCounts[0] * brickCounts[1]);
+        return vec3i(bx << brickBits, by << brickBits, bz << brickBits);
+    }
+
+    int brickSize() const {
+        return 1 << brickBits;
+    }
+
+    uint64_t brickVoxels() const {
+        return 1ull << (3 * brickBits);
+    }
+
+    int numBricks() const {
+        return (int)brickIndices.size();
+    }
+
+    template <int Dim>
+    typename std::enable_if<Dim >= 0 && Dim <= 2, uint64_t>::type size() const {
+        return sizes_[Dim];
+    }
+
+    void resize(int sizeX, int sizeY, int sizeZ, int brickSize = 8) {
+        LIBCBCT_ASSERT(brickSize > 0 && (brickSize & (brickSize - 1)) == 0, "Brick size must be a power of two!");
+
+        this->sizeX = sizeX;
+        this->sizeY = sizeY;
+        this->sizeZ = sizeZ;
+        this->brickBits = 0;
+        while ((1 << brickBits) < brickSize) {
+            brickBits++;
+        }
+
+        brickCounts[0] = (sizeX + brickSize - 1) >> brickBits;
+        brickCounts[1] = (sizeY + brickSize - 1) >> brickBits;
+        brickCounts[2] = (sizeZ + brickSize - 1) >> brickBits;
+        const int nBricks = brickCounts[0] * brickCounts[1] * brickCounts[2];
+
+        // Sort the bricks along the Z-order curve. The brick grid is not padded to a power of two, so that the
+        // Morton codes are only used for ordering and the bricks are packed without holes.
+        std::vector<uint64_t> codes(nBricks);
+        for (int bz = 0; bz < brickCounts[2]; bz++) {
+            for (int by = 0; by < brickCounts[1]; by++) {
+                for (int bx = 0; bx < brickCounts[0]; bx++) {
+                    codes[(bz * brickCounts[1] + by) * brickCounts[0] + bx] = mortonEncode3(bx, by, bz);
+                }
+            }
+        }
+
+        brickIndices.resize(nBricks);
+        std::iota(brickIndices.begin(), brickIndices.end(), 0);
+        std::sort(brickIndices.begin(), brickIndices.end(),
+                  [&codes](uint32_t a, uint32_t b) { return codes[a] < codes[b]; });
+
+        brickSlots.resize(nBricks);
+        for (int i = 0; i < nBricks; i++) {
+            brickSlots[brickIndices[i]] = i;
+        }
+
+        data.reset(nullptr);
+        if (nBricks != 0) {
+            const uint64_t total = nBricks * brickVoxels();
+            // Zero-initialized, which also keeps the padding of the boundary bricks at zero
+            data = allocateTracked<T>(total, MemoryCategory::Volume);
+        }
+    }
+
+    //! Set all the voxels to zero, keeping the storage
+    void clear() {
+        const uint64_t nVoxels = brickVoxels();
+        OMP_PARALLEL_FOR(int b = 0; b < numBricks(); b++) {
+            std::memset(data.get() + nVoxels * b, 0, sizeof(T) * nVoxels);
+        }
+    }
+
+    //! Copy voxels from a volume with linear layout, which must have the same size
+    void copyFrom(const Volume<T> &volume) {
+        LIBCBCT_ASSERT(volume.template size<0>() == sizeX && volume.template size<1>() == sizeY &&
+                           volume.template size<2>() == sizeZ,
+                       "Volume size mismatch!");
+
+        const int bs = brickSize();
+        OMP_PARALLEL_FOR(int b = 0; b < numBricks(); b++) {
+            const vec3i org = brickOrigin(b);
+            const int nx = std::min(bs, (int)sizeX - org.x);
+            const int ny = std::min(bs, (int)sizeY - org.y);
+            const int nz = std::min(bs, (int)sizeZ - org.z);
+            T *const brick = brickPtr(b);
+            for (int z = 0; z < nz; z++) {
+                for (int y = 0; y < ny; y++) {
+                    const T *src = volume.ptr() + ((uint64_t)(org.z + z) * sizeY + (org.y + y)) * sizeX + org.x;
+                    std::memcpy(brick + ((z << brickBits) + y) * bs, src, sizeof(T) * nx);
+                }
+            }
+        }
+    }
+
+    //! Copy voxels to the slices [zOffset, zOffset + sizeZ) of a volume with linear layout and the same sizeX/Y
+    void copyTo(Volume<T> &volume, int zOffset = 0) const {
+        LIBCBCT_ASSERT(volume.template size<0>() == sizeX && volume.template size<1>() == sizeY && zOffset >= 0 &&
+                           volume.template size<2>() >= zOffset + sizeZ,
+                       "Volume size mismatch!");
+
+        const int bs = brickSize();
+        T *const out = volume.ptr();
+        OMP_PARALLEL_FOR(int b = 0; b < numBricks(); b++) {
+            const vec3i org = brickOrigin(b);
+            const int nx = std::min(bs, (int)sizeX - org.x);
+            const int ny = std::min(bs, (int)sizeY - org.y);
+            const int nz = std::min(bs, (int)sizeZ - org.z);
+            const T *const brick = brickPtr(b);
+            for (int z = 0; z < nz; z++) {
+                for (int y = 0; y < ny; y++) {
+                    T *dst = out + ((uint64_t)(zOffset + org.z + z) * sizeY + (org.y + y)) * sizeX + org.x;
+                    std::memcpy(dst, brick + ((z << brickBits) + y) * bs, sizeof(T) * nx);
+                }
+            }
+        }
+    }
+
+    Volume<T> toVolume() const {
+        Volume<T> volume(sizeX, sizeY, sizeZ);
+        copyTo(volume);
+        return volume;
+    }
+
+    /**
+     * @brief Extract an orthogonal slice into a row-major buffer
+     * @details For axis 0, 1 and 2, the slice has the size of (sizeY, sizeZ), (sizeX, sizeZ) and (sizeX, sizeY), and
+     * the first of the two remaining axes runs fastest. Each brick crossing the slice contributes a single plane of
+     * brickSize^2 voxels.
+     */
+    void getSlice(int axis, int index, T *out) const {
+        LIBCBCT_ASSERT(axis >= 0 && axis <= 2, "Slice axis must be 0, 1 or 2!");
+        LIBCBCT_ASSERT(index >= 0 && index < sizes_[axis], "Slice index out of bounds!");
+
+        const int ua = axis == 0 ? 1 : 0;
+        const int va = axis == 2 ? 1 : 2;
+        const int width = sizes_[ua];
+        const int height = sizes_[va];
+        const int bs = brickSize();
+        const int w = index & (bs - 1);
+
+        OMP_PARALLEL_FOR(int bv = 0; bv < brickCounts[va]; bv++) {
+            int bc[3];
+            bc[axis] = index >> brickBits;
+            bc[va] = bv;
+            for (int bu = 0; bu < brickCounts[ua]; bu++) {
+                bc[ua] = bu;
+                const uint32_t slot = brickSlots[(bc[2] * brickCounts[1] + bc[1]) * brickCounts[0] + bc[0]];
+                const T *const brick = brickPtr(slot);
+                const int nu = std::min(bs, width - (bu << brickBits));
+                const int nv = std::min(bs, height - (bv << brickBits));
+                for (int v = 0; v < nv; v++) {
+                    T *dst = out + (uint64_t)((bv << brickBits) + v) * width + (bu << brickBits);
+                    for (int u = 0; u < nu; u++) {
+                        int l[3];
+                        l[axis] = w;
+                        l[ua] = u;
+                        l[va] = v;
+                        dst[u] = brick[(((l[2] << brickBits) + l[1]) << brickBits) + l[0]];
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename Func>
+    void forEach(Func &&func) {
+        const int bs = brickSize();
+        OMP_PARALLEL_FOR(int b = 0; b < numBricks(); b++) {
+            const vec3i org = brickOrigin(b);
+            const int nx = std::min(bs, (int)sizeX - org.x);
+            const int ny = std::min(bs, (int)sizeY - org.y);
+            const int nz = std::min(bs, (int)sizeZ - org.z);
+            T *const brick = brickPtr(b);
+            for (int z = 0; z < nz; z++) {
+                for (int y = 0; y < ny; y++) {
+                    T *row = brick + ((z << brickBits) + y) * bs;
+                    for (int x = 0; x < nx; x++) {
+                        row[x] = func(row[x]);
+                    }
+                }
+            }
+        }
+    }
+
+    std::tuple<T, T> getMinMax() const {
+        std::vector<T> localMins(numBricks());
+        std::vector<T> localMaxs(numBricks());
+        const int bs = brickSize();
+        OMP_PARALLEL_FOR(int b = 0; b < numBricks(); b++) {
+            const vec3i org = brickOrigin(b);
+            const int nx = std::min(bs, (int)sizeX - org.x);
+            const int ny = std::min(bs, (int)sizeY - org.y);
+            const int nz = std::min(bs, (int)sizeZ - org.z);
+            const T *const brick = brickPtr(b);
+
+            T localMin = std::numeric_limits<T>::max();
+            T localMax = std::numeric_limits<T>::lowest();
+            for (int z = 0; z < nz; z++) {
+                for (int y = 0; y < ny; y++) {
+                    const T *row = brick + ((z << brickBits) + y) * bs;
+                    for (int x = 0; x < nx; x++) {
+                        localMin = std::min(localMin, row[x]);
+                        localMax = std::max(localMax, row[x]);
+                    }
+                }
+            }
+
+            localMins[b] = localMin;
+            localMaxs[b] = localMax;
+        }
+
+        T minVal = std::numeric_limits<T>::max();
+        T maxVal = std::numeric_limits<T>::lowest();
+        for (int b = 0; b < numBricks(); b++) {
+            minVal = std::min(minVal, localMins[b]);
+            maxVal = std::max(maxVal, localMaxs[b]);
+        }
+
+        return std::make_tuple(minVal, maxVal);
+    }
+
+    VolumeType type() const {
+        if constexpr (std::is_same_v<T, uint8_t>) {
+            return VolumeType::Uint8;
+        } else if constexpr (std::is_same_v<T, uint16_t>) {
+            return VolumeType::Uint16;
+        } else if constexpr (std::is_same_v<T, uint32_t>) {
+            return VolumeType::Uint32;
+        } else if constexpr (std::is_same_v<T, float>) {
+            return VolumeType::Float32;
+        } else {
+            static_assert(std::is_same_v<T, double>, "Unsupported voxel type!");
+            return VolumeType::Float64;
+        }
+    }
+
+private:
+    uint64_t offset(int x, int y, int z) const {
+        const int mask = (1 << brickBits) - 1;
+        const uint32_t brick =
+            ((z >> brickBits) * brickCounts[1] + (y >> brickBits)) * brickCounts[0] + (x >> brickBits);
+        const uint64_t local = ((((uint64_t)(z & mask) << brickBits) + (y & mask)) << brickBits) + (x & mask);
+        return (uint64_t)brickSlots[brick] * brickVoxels() + local;
+    }
+
+    union {
+        struct {
+            uint64_t sizeX;
+            uint64_t sizeY;
+            uint64_t sizeZ;
+        };
+        uint64_t sizes_[3];
+    };
+    int brickBits = 3;
+    int brickCounts[3] = { 0, 0, 0 };
+    std::vector<uint32_t> brickIndices;  // Linear brick index for each position in Morton order
+    std::vector<uint32_t> brickSlots;    // Position in Morton order for each linear brick index
+    TrackedArray<T> data = nullptr;
+};
+
+using BrickedVolumeU8 = BrickedVolume<uint8_t>;
+using BrickedVolumeU16 = BrickedVolume<uint16_t>;
+using BrickedVolumeU32 = BrickedVolume<uint32_t>;
+using BrickedVolumeF32 = BrickedVolume<float>;
+using BrickedVolumeF64 = BrickedVolume<double>;
+
+#endif  // LIBCBCT_BRICKED_VOLUME_H
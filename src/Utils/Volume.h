@@ -7,14 +7,19 @@
 
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <tuple>
 #include <vector>
+#include <limits>
 #include <algorithm>
-#include <functional>
 
 #include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
 #include "Common/OpenMP.h"
+#include "Common/Parallel.h"
 #include "Utils/ImageUtils.h"
+#include "Utils/VolumeStatistics.h"
 
 enum class VolumeType {
     Uint8,
@@ -24,6 +29,59 @@ enum class VolumeType {
     Float64,
 };
 
+//! Number of bytes per voxel of the given type
+inline size_t volumeTypeSize(VolumeType type) {
+    switch (type) {
+    case VolumeType::Uint8:
+        return 1;
+    case VolumeType::Uint16:
+        return 2;
+    case VolumeType::Uint32:
+    case VolumeType::Float32:
+        return 4;
+    case VolumeType::Float64:
+        return 8;
+    default:
+        LIBCBCT_ERROR("Unknown volume type!");
+        return 0;
+    }
+}
+
+//! Name of the voxel type used in metadata files, e.g., "uint16"
+inline const char *volumeTypeName(VolumeType type) {
+    switch (type) {
+    case VolumeType::Uint8:
+        return "uint8";
+    case VolumeType::Uint16:
+        return "uint16";
+    case VolumeType::Uint32:
+        return "uint32";
+    case VolumeType::Float32:
+        return "float32";
+    case VolumeType::Float64:
+        return "float64";
+    default:
+        LIBCBCT_ERROR("Unknown volume type!");
+        return "";
+    }
+}
+
+inline VolumeType volumeTypeFromName(const std::string &name) {
+    for (VolumeType type : { VolumeType::Uint8, VolumeType::Uint16, VolumeType::Uint32, VolumeType::Float32,
+                             VolumeType::Float64 }) {
+        if (name == volumeTypeName(type)) {
+            return type;
+        }
+    }
+    LIBCBCT_ERROR("Unknown volume type: %s", name.c_str());
+    return VolumeType::Float32;
+}
+
+namespace libcbct::expr {
+template <typename E>
+struct VolumeExpr;
+}  // namespace libcbct::expr
+
 template <typename T>
 class Volume {
 public:
@@ -37,19 +95,39 @@ public:
     Volume(const Volume<T> &other)
         : Volume(other.sizeX, other.sizeY, other.sizeZ) {
         std::memcpy(data.get(), other.data.get(), sizeof(T) * sizeX * sizeY * sizeZ);
+        stats = other.cachedStatistics();
     }
 
     Volume(Volume<T> &&other)
         : sizeX(other.sizeX)
         , sizeY(other.sizeY)
         , sizeZ(other.sizeZ)
-        , data(std::move(other.data)) {
+        , data(std::move(other.data))
+        , stats(other.takeStatistics()) {
         other.sizeX = 0;
         other.sizeY = 0;
         other.sizeZ = 0;
         other.data = nullptr;
     }
 
+    //! Evaluate a voxel-wise expression (see VolumeExpr.h) into a new volume
+    template <typename E>
+    Volume(const libcbct::expr::VolumeExpr<E> &expr);
+
+    /**
+     * @brief Volume using the given storage without copying it, e.g., a memory-mapped file
+     * @details The storage is kept alive by the volume (and released by its deleter, if any). Copies of the volume
+     * are deep copies as usual, while resize() replaces the storage with a newly allocated one.
+     */
+    static Volume wrap(uint64_t sizeX, uint64_t sizeY, uint64_t sizeZ, std::shared_ptr<T[]> storage) {
+        Volume volume;
+        volume.sizeX = sizeX;
+        volume.sizeY = sizeY;
+        volume.sizeZ = sizeZ;
+        volume.data = std::move(storage);
+        return volume;
+    }
+
     virtual ~Volume() = default;
 
     Volume &operator=(const Volume<T> &other) {
@@ -58,6 +136,7 @@ public:
         sizeZ = other.sizeZ;
         this->resize(sizeX, sizeY, sizeZ);
         std::memcpy(data.get(), other.data.get(), sizeof(T) * sizeX * sizeY * sizeZ);
+        stats = other.cachedStatistics();
         return *this;
     }
 
@@ -66,6 +145,7 @@ public:
         sizeY = other.sizeY;
         sizeZ = other.sizeZ;
         data = std::move(other.data);
+        stats = other.takeStatistics();
 
         other.sizeX = 0;
         other.sizeY = 0;
@@ -75,12 +155,11 @@ public:
         return *this;
     }
 
-    T &operator()(int x, int y, int z) {
-        LIBCBCT_ASSERT(x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ,
-                       "Volume index out of bounds!");
-        return data[((uint64_t)z * sizeY + (uint64_t)y) * sizeX + (uint64_t)x];
-    }
+    //! Evaluate a voxel-wise expression in a single parallel pass, reusing the storage if the size matches
+    template <typename E>
+    Volume &operator=(const libcbct::expr::VolumeExpr<E> &expr);
 
+    //! Voxel value. Voxels are written through ptr(), forEach() or transform(), which discard the cached statistics.
     T operator()(int x, int y, int z) const {
         LIBCBCT_ASSERT(x >= 0 && x < sizeX && y >= 0 && y < sizeY && z >= 0 && z < sizeZ,
                        "Volume index out of bounds!");
@@ -123,87 +202,147 @@ public:
         return fmaf(w, (v1 - v0), v0);
     }
 
-    T *ptr() const {
+    /**
+     * @brief Writable voxel array, which discards the cached statistics
+     * @details The cache is discarded once per call rather than per voxel, so that loops take the pointer once
+     * before writing. Statistics computed later are cached again, so that a pointer kept across a call of
+     * statistics() must not be written through without calling markModified() again.
+     */
+    T *ptr() {
+        markModified();
         return data.get();
     }
 
-    void forEach(const typename std::function<T(T)> &func) {
-        OMP_PARALLEL_FOR(int z = 0; z < sizeZ; z++) {
-            for (int y = 0; y < sizeY; y++) {
-                for (int x = 0; x < sizeX; x++) {
-                    (*this)(x, y, z) = func((*this)(x, y, z));
-                }
+    const T *ptr() const {
+        return data.get();
+    }
+
+    //! Number of voxels
+    uint64_t count() const {
+        return sizeX * sizeY * sizeZ;
+    }
+
+    /**
+     * @brief Apply a voxel-wise function in place
+     * @details The callable is invoked as func(T) -> T on contiguous chunks of the voxel array, so that it can be
+     * inlined and vectorized.
+     */
+    template <typename Func>
+    void forEach(Func &&func) {
+        T *const dst = data.get();
+        parallelForChunks(count(), [&](int64_t, uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++) {
+                dst[i] = func(dst[i]);
             }
-        }
+        });
+        markModified();
     }
 
-    T reduce(const typename std::function<T(T, T)> &func, const T &init) const {
-        auto buf = std::make_unique<T[]>(sizeZ);
-        std::fill_n(buf.get(), sizeZ, init);
+    /**
+     * @brief Overwrite voxels with a function of the voxels of other volumes at the same positions
+     * @details The callable is invoked as func(srcs[i]...) -> T. Any number of source volumes of the same size is
+     * accepted, and this volume itself may be one of them.
+     */
+    template <typename Func, typename... Us>
+    void transform(Func &&func, const Volume<Us> &...srcs) {
+        LIBCBCT_ASSERT(((srcs.count() == count()) && ...), "Volume size mismatch!");
+
+        T *const dst = data.get();
+        parallelForChunks(count(), [&](int64_t, uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++) {
+                dst[i] = func(srcs.ptr()[i]...);
+            }
+        });
+        markModified();
+    }
 
-        OMP_PARALLEL_FOR(int z = 0; z < sizeZ; z++) {
-            for (int y = 0; y < sizeY; y++) {
-                for (int x = 0; x < sizeX; x++) {
-                    buf[z] = func(buf[z], (*this)(x, y, z));
-                }
+    /**
+     * @brief Reduce the transformed voxels
+     * @details The callable "op" is invoked as op(T) -> R and "reduce" as reduce(R, R) -> R. Each chunk is reduced
+     * from "init", and the partial results are combined in chunk order, so that the result does not depend on the
+     * number of threads.
+     */
+    template <typename R, typename Reduce, typename Op>
+    R transformReduce(const R &init, Reduce &&reduce, Op &&op) const {
+        const T *const src = data.get();
+        std::vector<R> partials(numParallelChunks(count()), init);
+        parallelForChunks(count(), [&](int64_t c, uint64_t begin, uint64_t end) {
+            R acc = init;
+            for (uint64_t i = begin; i < end; i++) {
+                acc = reduce(acc, op(src[i]));
             }
-        }
+            partials[c] = acc;
+        });
 
-        T ret = init;
-        for (int z = 0; z < sizeZ; z++) {
-            ret = func(ret, buf[z]);
+        R ret = init;
+        for (const R &p : partials) {
+            ret = reduce(ret, p);
         }
-
         return ret;
     }
 
+    template <typename Reduce>
+    T reduce(Reduce &&func, const T &init) const {
+        return transformReduce(init, func, [](T x) -> T { return x; });
+    }
+
     T getMin() const {
-        return reduce([](T a, T b) -> T { return std::min(a, b); }, std::numeric_limits<T>::infinity());
+        return reduce([](T a, T b) -> T { return std::min(a, b); }, std::numeric_limits<T>::max());
     }
 
     T getMax() const {
-        const T init = [] {
-            if constexpr (std::is_floating_point_v<T>) {
-                return -std::numeric_limits<T>::infinity();
-            } else if constexpr (std::is_signed_v<T>) {
-                return std::numeric_limits<T>::lowest();
-            } else {
-                return T{ 0 };
-            }
-        }();
-
-        return reduce([](const T &a, const T &b) -> T { return std::max(a, b); }, init);
+        return reduce([](T a, T b) -> T { return std::max(a, b); }, std::numeric_limits<T>::lowest());
     }
 
     std::tuple<T, T> getMinMax() const {
-        std::vector<T> localMins(sizeZ);
-        std::vector<T> localMaxs(sizeZ);
-        OMP_PARALLEL_FOR(int z = 0; z < sizeZ; z++) {
-            T localMin = std::numeric_limits<T>::infinity();
-            T localMax = std::is_signed_v<T> ? -std::numeric_limits<T>::infinity() : 0;
-
-            for (int y = 0; y < sizeY; y++) {
-                for (int x = 0; x < sizeX; x++) {
-                    const T val = (*this)(x, y, z);
-                    localMin = std::min(localMin, val);
-                    localMax = std::max(localMax, val);
-                }
-            }
-
-            localMins[z] = localMin;
-            localMaxs[z] = localMax;
+        if (const std::shared_ptr<const VolumeStatistics> cached = cachedStatistics()) {
+            return std::make_tuple((T)cached->minVal, (T)cached->maxVal);
         }
 
-        T minVal = std::numeric_limits<T>::infinity();
-        T maxVal = std::is_signed_v<T> ? -std::numeric_limits<T>::infinity() : 0;
-        for (int z = 0; z < sizeZ; z++) {
-            minVal = std::min(minVal, localMins[z]);
-            maxVal = std::max(maxVal, localMaxs[z]);
+        const T *const src = data.get();
+        std::vector<T> localMins(numParallelChunks(count()));
+        std::vector<T> localMaxs(numParallelChunks(count()));
+        parallelForChunks(count(), [&](int64_t c, uint64_t begin, uint64_t end) {
+            T localMin = std::numeric_limits<T>::max();
+            T localMax = std::numeric_limits<T>::lowest();
+            for (uint64_t i = begin; i < end; i++) {
+                localMin = std::min(localMin, src[i]);
+                localMax = std::max(localMax, src[i]);
+            }
+            localMins[c] = localMin;
+            localMaxs[c] = localMax;
+        });
+
+        T minVal = std::numeric_limits<T>::max();
+        T maxVal = std::numeric_limits<T>::lowest();
+        for (size_t c = 0; c < localMins.size(); c++) {
+            minVal = std::min(minVal, localMins[c]);
+            maxVal = std::max(maxVal, localMaxs[c]);
         }
 
         return std::make_tuple(minVal, maxVal);
     }
 
+    /**
+     * @brief Statistics of the voxel values
+     * @details The statistics are computed in a single pass on the first call and cached until the volume is
+     * modified. The non-const ptr() discards the cache, as do all the other modifying methods. The cache is guarded
+     * by a mutex, so that threads may read the statistics of a const volume at once, and they are computed once.
+     */
+    const VolumeStatistics &statistics() const {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        if (!stats) {
+            stats = std::make_shared<const VolumeStatistics>(VolumeStatistics::compute(data.get(), count()));
+        }
+        return *stats;
+    }
+
+    //! Discard the cached statistics after the voxels have been modified
+    void markModified() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.reset();
+    }
+
     template <int Dim>
     typename std::enable_if<Dim >= 0 && Dim <= 2, uint64_t>::type size() const {
         return sizes_[Dim];
@@ -213,20 +352,30 @@ public:
         this->sizeX = sizeX;
         this->sizeY = sizeY;
         this->sizeZ = sizeZ;
+        markModified();
 
         if (!data) {
-            data.reset(nullptr);
+            data.reset();
         }
 
         if (sizeX * sizeY * sizeZ != 0) {
-            data = std::make_unique<T[]>(sizeX * sizeY * sizeZ);
-            std::memset(data.get(), 0, sizeof(T) * sizeX * sizeY * sizeZ);
+            data = allocateTracked<T>(sizeX * sizeY * sizeZ, MemoryCategory::Volume);
         }
     }
 
     VolumeType type() const;
 
 private:
+    std::shared_ptr<const VolumeStatistics> cachedStatistics() const {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return stats;
+    }
+
+    std::shared_ptr<const VolumeStatistics> takeStatistics() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return std::move(stats);
+    }
+
     union {
         struct {
             uint64_t sizeX;
@@ -235,7 +384,9 @@ private:
         };
         uint64_t sizes_[3];
     };
-    std::unique_ptr<T[]> data = nullptr;
+    std::shared_ptr<T[]> data = nullptr;
+    mutable std::shared_ptr<const VolumeStatistics> stats = nullptr;
+    mutable std::mutex statsMutex;
 };
 
 using VolumeU8 = Volume<uint8_t>;
@@ -269,4 +420,6 @@ inline VolumeType Volume<double>::type() const {
     return VolumeType::Float64;
 }
 
+#include "Utils/VolumeExpr.h"
+
 #endif  // LIBCBCT_VOLUME_H
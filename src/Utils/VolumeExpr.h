@@ -0,0 +1,372 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_VOLUME_EXPR_H
+#define LIBCBCT_VOLUME_EXPR_H
+
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include "Common/Api.h"
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+#include "Common/Parallel.h"
+#include "Utils/Volume.h"
+
+// -----------------------------------------------------------------------------
+// Lazy voxel-wise expressions
+// -----------------------------------------------------------------------------
+// Arithmetic on volumes builds a tree of small expression nodes instead of temporary volumes. The tree is
+// evaluated voxel by voxel in a single parallel pass when it is assigned to a Volume, or when it is consumed
+// chunk by chunk with evaluate(), e.g., by an exporter.
+//
+// The nodes and the functions min, max, clamp, cast, map and evaluate are in the namespace libcbct::expr, so that
+// they are found by argument-dependent lookup when an argument is an expression, and do not hide std::min etc.
+// They are qualified when all the arguments are volumes or scalars. The arithmetic operators are global like Volume.
+//
+//     namespace expr = libcbct::expr;
+//     tomogram = expr::max(0.0f, tomogram) / maxVal;
+//     VolumeU16 quantized = cast<uint16_t>(clamp(tomogram * 50000.0f, 0.0f, 50000.0f));
+// -----------------------------------------------------------------------------
+
+namespace libcbct::expr {
+
+/**
+ * @brief Base class of voxel-wise expressions (CRTP)
+ * @details A derived class E provides "value_type", "count()", "size(dim)" and "operator[](i)", which returns the
+ * value of the i-th voxel in the linear (x-fastest) order.
+ */
+template <typename E>
+struct VolumeExpr {
+    const E &self() const {
+        return static_cast<const E &>(*this);
+    }
+};
+
+template <typename T>
+struct VolumeTerminal : public VolumeExpr<VolumeTerminal<T>> {
+    using value_type = T;
+
+    explicit VolumeTerminal(const Volume<T> &volume)
+        : data(volume.ptr())
+        , sizes{ volume.template size<0>(), volume.template size<1>(), volume.template size<2>() } {
+    }
+
+    uint64_t count() const {
+        return sizes[0] * sizes[1] * sizes[2];
+    }
+
+    uint64_t size(int dim) const {
+        return sizes[dim];
+    }
+
+    LIBCBCT_FORCEINLINE T operator[](uint64_t i) const {
+        return data[i];
+    }
+
+    const T *data;
+    uint64_t sizes[3];
+};
+
+template <typename Op, typename E>
+struct UnaryVolumeExpr : public VolumeExpr<UnaryVolumeExpr<Op, E>> {
+    using value_type = std::decay_t<decltype(std::declval<Op>()(std::declval<typename E::value_type>()))>;
+
+    UnaryVolumeExpr(const Op &op, const E &e)
+        : op(op)
+        , e(e) {
+    }
+
+    uint64_t count() const {
+        return e.count();
+    }
+
+    uint64_t size(int dim) const {
+        return e.size(dim);
+    }
+
+    LIBCBCT_FORCEINLINE value_type operator[](uint64_t i) const {
+        return op(e[i]);
+    }
+
+    Op op;
+    E e;
+};
+
+template <typename Op, typename L, typename R>
+struct BinaryVolumeExpr : public VolumeExpr<BinaryVolumeExpr<Op, L, R>> {
+    using value_type = std::decay_t<decltype(std::declval<Op>()(std::declval<typename L::value_type>(),
+                                                                std::declval<typename R::value_type>()))>;
+
+    BinaryVolumeExpr(const L &l, const R &r)
+        : l(l)
+        , r(r) {
+        LIBCBCT_ASSERT(l.count() == 0 || r.count() == 0 || l.count() == r.count(), "Volume size mismatch!");
+    }
+
+    //! Scalar operands report zero voxels, and the size is taken from the other operand
+    uint64_t count() const {
+        return std::max(l.count(), r.count());
+    }
+
+    uint64_t size(int dim) const {
+        return l.count() != 0 ? l.size(dim) : r.size(dim);
+    }
+
+    LIBCBCT_FORCEINLINE value_type operator[](uint64_t i) const {
+        return Op()(l[i], r[i]);
+    }
+
+    L l;
+    R r;
+};
+
+//! Scalar broadcast to every voxel
+template <typename T>
+struct ScalarExpr : public VolumeExpr<ScalarExpr<T>> {
+    using value_type = T;
+
+    explicit ScalarExpr(const T &value)
+        : value(value) {
+    }
+
+    uint64_t count() const {
+        return 0;
+    }
+
+    uint64_t size(int) const {
+        return 0;
+    }
+
+    LIBCBCT_FORCEINLINE T operator[](uint64_t) const {
+        return value;
+    }
+
+    T value;
+};
+
+// -----------------------------------------------------------------------------
+// Voxel-wise operators
+// -----------------------------------------------------------------------------
+
+namespace detail {
+
+struct AddOp {
+    template <typename A, typename B>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a, const B &b) const {
+        return a + b;
+    }
+};
+
+struct SubOp {
+    template <typename A, typename B>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a, const B &b) const {
+        return a - b;
+    }
+};
+
+struct MulOp {
+    template <typename A, typename B>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a, const B &b) const {
+        return a * b;
+    }
+};
+
+struct DivOp {
+    template <typename A, typename B>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a, const B &b) const {
+        return a / b;
+    }
+};
+
+// Same as std::min and std::max, which return the first operand when the operands are unordered (e.g., NaN), so
+// that max(0.0f, x) clamps NaN to zero while max(x, 0.0f) keeps it
+struct MinOp {
+    template <typename A, typename B>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a, const B &b) const {
+        using C = std::common_type_t<A, B>;
+        return b < a ? (C)b : (C)a;
+    }
+};
+
+struct MaxOp {
+    template <typename A, typename B>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a, const B &b) const {
+        using C = std::common_type_t<A, B>;
+        return a < b ? (C)b : (C)a;
+    }
+};
+
+struct NegateOp {
+    template <typename A>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a) const {
+        return -a;
+    }
+};
+
+template <typename U>
+struct CastOp {
+    template <typename A>
+    LIBCBCT_FORCEINLINE U operator()(const A &a) const {
+        return static_cast<U>(a);
+    }
+};
+
+template <typename T>
+struct ClampOp {
+    template <typename A>
+    LIBCBCT_FORCEINLINE auto operator()(const A &a) const {
+        using C = std::common_type_t<A, T>;
+        return a < lo ? (C)lo : (hi < a ? (C)hi : (C)a);
+    }
+
+    T lo, hi;
+};
+
+template <typename X>
+struct IsVolume : std::false_type {};
+
+template <typename T>
+struct IsVolume<Volume<T>> : std::true_type {};
+
+template <typename X>
+constexpr bool isExprOperand = IsVolume<std::decay_t<X>>::value ||
+                               std::is_base_of_v<VolumeExpr<std::decay_t<X>>, std::decay_t<X>>;
+
+template <typename X>
+constexpr bool isScalarOperand = std::is_arithmetic_v<std::decay_t<X>>;
+
+template <typename A, typename B>
+constexpr bool isBinaryOperands = (isExprOperand<A> && (isExprOperand<B> || isScalarOperand<B>)) ||
+                                  (isScalarOperand<A> && isExprOperand<B>);
+
+template <typename T>
+VolumeTerminal<T> toExpr(const Volume<T> &volume) {
+    return VolumeTerminal<T>(volume);
+}
+
+template <typename E>
+const E &toExpr(const VolumeExpr<E> &expr) {
+    return expr.self();
+}
+
+template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+ScalarExpr<T> toExpr(const T &value) {
+    return ScalarExpr<T>(value);
+}
+
+template <typename X>
+using ExprOf = std::decay_t<decltype(toExpr(std::declval<const X &>()))>;
+
+template <typename Op, typename A, typename B>
+BinaryVolumeExpr<Op, ExprOf<A>, ExprOf<B>> makeBinary(const A &a, const B &b) {
+    return BinaryVolumeExpr<Op, ExprOf<A>, ExprOf<B>>(toExpr(a), toExpr(b));
+}
+
+template <typename Op, typename A>
+UnaryVolumeExpr<Op, ExprOf<A>> makeUnary(const Op &op, const A &a) {
+    return UnaryVolumeExpr<Op, ExprOf<A>>(op, toExpr(a));
+}
+
+}  // namespace detail
+
+template <typename A, typename B, typename = std::enable_if_t<detail::isBinaryOperands<A, B>>>
+auto min(const A &a, const B &b) {
+    return detail::makeBinary<detail::MinOp>(a, b);
+}
+
+template <typename A, typename B, typename = std::enable_if_t<detail::isBinaryOperands<A, B>>>
+auto max(const A &a, const B &b) {
+    return detail::makeBinary<detail::MaxOp>(a, b);
+}
+
+template <typename A, typename T, typename = std::enable_if_t<detail::isExprOperand<A> && std::is_arithmetic_v<T>>>
+auto clamp(const A &a, const T &lo, const T &hi) {
+    return detail::makeUnary(detail::ClampOp<T>{ lo, hi }, a);
+}
+
+template <typename U, typename A, typename = std::enable_if_t<detail::isExprOperand<A>>>
+auto cast(const A &a) {
+    return detail::makeUnary(detail::CastOp<U>(), a);
+}
+
+//! Apply an arbitrary callable to each voxel of the expression
+template <typename A, typename Func, typename = std::enable_if_t<detail::isExprOperand<A>>>
+auto map(const A &a, const Func &func) {
+    return detail::makeUnary(func, a);
+}
+
+// -----------------------------------------------------------------------------
+// Evaluation
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Evaluate the voxels [begin, end) of an expression into a buffer in parallel
+ */
+template <typename E, typename T>
+void evaluate(const VolumeExpr<E> &expr, uint64_t begin, uint64_t end, T *out) {
+    const E &e = expr.self();
+    parallelForChunks(end - begin, [&](int64_t, uint64_t chunkBegin, uint64_t chunkEnd) {
+        OMP_SIMD
+        for (uint64_t i = chunkBegin; i < chunkEnd; i++) {
+            out[i] = static_cast<T>(e[begin + i]);
+        }
+    });
+}
+
+}  // namespace libcbct::expr
+
+// -----------------------------------------------------------------------------
+// Arithmetic operators (global like Volume, so that they are also found for volume operands)
+// -----------------------------------------------------------------------------
+
+template <typename A, typename B, typename = std::enable_if_t<libcbct::expr::detail::isBinaryOperands<A, B>>>
+auto operator+(const A &a, const B &b) {
+    return libcbct::expr::detail::makeBinary<libcbct::expr::detail::AddOp>(a, b);
+}
+
+template <typename A, typename B, typename = std::enable_if_t<libcbct::expr::detail::isBinaryOperands<A, B>>>
+auto operator-(const A &a, const B &b) {
+    return libcbct::expr::detail::makeBinary<libcbct::expr::detail::SubOp>(a, b);
+}
+
+template <typename A, typename B, typename = std::enable_if_t<libcbct::expr::detail::isBinaryOperands<A, B>>>
+auto operator*(const A &a, const B &b) {
+    return libcbct::expr::detail::makeBinary<libcbct::expr::detail::MulOp>(a, b);
+}
+
+template <typename A, typename B, typename = std::enable_if_t<libcbct::expr::detail::isBinaryOperands<A, B>>>
+auto operator/(const A &a, const B &b) {
+    return libcbct::expr::detail::makeBinary<libcbct::expr::detail::DivOp>(a, b);
+}
+
+template <typename A, typename = std::enable_if_t<libcbct::expr::detail::isExprOperand<A>>>
+auto operator-(const A &a) {
+    return libcbct::expr::detail::makeUnary(libcbct::expr::detail::NegateOp(), a);
+}
+
+template <typename T>
+template <typename E>
+Volume<T>::Volume(const libcbct::expr::VolumeExpr<E> &expr)
+    : Volume(expr.self().size(0), expr.self().size(1), expr.self().size(2)) {
+    libcbct::expr::evaluate(expr, 0, count(), data.get());
+}
+
+template <typename T>
+template <typename E>
+Volume<T> &Volume<T>::operator=(const libcbct::expr::VolumeExpr<E> &expr) {
+    const E &e = expr.self();
+    if (e.size(0) != sizeX || e.size(1) != sizeY || e.size(2) != sizeZ) {
+        // The expression may still refer to the current voxels, so it is evaluated into new storage
+        Volume<T> result(expr);
+        *this = std::move(result);
+    } else {
+        libcbct::expr::evaluate(expr, 0, count(), data.get());
+        markModified();
+    }
+    return *this;
+}
+
+#endif  // LIBCBCT_VOLUME_EXPR_H
@@ -0,0 +1,91 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_VOLUME_PYRAMID_H
+#define LIBCBCT_VOLUME_PYRAMID_H
+
+#include <algorithm>
+
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+#include "Utils/Volume.h"
+
+enum class PyramidFilter : int {
+    Box,       // Average of 2x2x2 voxels
+    Gaussian,  // Separable binomial filter [1, 3, 3, 1] / 8 over 4x4x4 voxels
+};
+
+//! Size of the volume reduced by a factor of two, rounding up
+inline int pyramidLevelSize(int size) {
+    return (size + 1) / 2;
+}
+
+//! Number of source slices, starting from 2 * z, needed to compute the reduced slice z
+inline int pyramidFilterReach(PyramidFilter filter) {
+    return filter == PyramidFilter::Box ? 2 : 3;
+}
+
+/**
+ * @brief Compute the slices [zBegin, zEnd) of the volume reduced by a factor of two
+ * @details Voxel (x, y, z) of the reduced volume is centered between the source voxels 2x and 2x + 1 (similarly
+ * for y and z), and the source voxels are clamped at the boundary. The reduced slice z reads the source slices
+ * up to min(2 * z + pyramidFilterReach(filter) - 1, sizeZ - 1).
+ */
+inline void downsample2x(const VolumeF32 &src, VolumeF32 &dst, PyramidFilter filter, int zBegin, int zEnd) {
+    const int sx = src.size<0>();
+    const int sy = src.size<1>();
+    const int sz = src.size<2>();
+    const int dx = dst.size<0>();
+    const int dy = dst.size<1>();
+    LIBCBCT_ASSERT(dx == pyramidLevelSize(sx) && dy == pyramidLevelSize(sy) && dst.size<2>() == pyramidLevelSize(sz),
+                   "Reduced volume size mismatch!");
+
+    const float *const in = src.ptr();
+    float *const out = dst.ptr();
+    const auto at = [&](int x, int y, int z) -> float {
+        x = clampi(x, 0, sx - 1);
+        y = clampi(y, 0, sy - 1);
+        z = clampi(z, 0, sz - 1);
+        return in[((uint64_t)z * sy + y) * sx + x];
+    };
+
+    static const float kWeights[4] = { 0.125f, 0.375f, 0.375f, 0.125f };
+    OMP_PARALLEL_FOR(int zy = 0; zy < (zEnd - zBegin) * dy; zy++) {
+        const int z = zBegin + zy / dy;
+        const int y = zy % dy;
+        float *const row = out + ((uint64_t)z * dy + y) * dx;
+        for (int x = 0; x < dx; x++) {
+            float sum = 0.0f;
+            if (filter == PyramidFilter::Box) {
+                for (int k = 0; k < 2; k++) {
+                    for (int j = 0; j < 2; j++) {
+                        sum += at(2 * x, 2 * y + j, 2 * z + k) + at(2 * x + 1, 2 * y + j, 2 * z + k);
+                    }
+                }
+                row[x] = sum * 0.125f;
+            } else {
+                for (int k = 0; k < 4; k++) {
+                    for (int j = 0; j < 4; j++) {
+                        float rowSum = 0.0f;
+                        for (int i = 0; i < 4; i++) {
+                            rowSum += kWeights[i] * at(2 * x - 1 + i, 2 * y - 1 + j, 2 * z - 1 + k);
+                        }
+                        sum += kWeights[k] * kWeights[j] * rowSum;
+                    }
+                }
+                row[x] = sum;
+            }
+        }
+    }
+    dst.markModified();
+}
+
+//! Volume reduced by a factor of two
+inline VolumeF32 downsample2x(const VolumeF32 &src, PyramidFilter filter) {
+    VolumeF32 dst(pyramidLevelSize(src.size<0>()), pyramidLevelSize(src.size<1>()), pyramidLevelSize(src.size<2>()));
+    downsample2x(src, dst, filter, 0, dst.size<2>());
+    return dst;
+}
+
+#endif  // LIBCBCT_VOLUME_PYRAMID_H
@@ -0,0 +1,311 @@
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#ifndef LIBCBCT_VOLUME_STATISTICS_H
+#define LIBCBCT_VOLUME_STATISTICS_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "Common/Api.h"
+#include "Common/Logging.h"
+#include "Common/OpenMP.h"
+#include "Common/Parallel.h"
+
+/**
+ * @brief Voxel value statistics computed in a single parallel pass
+ * @details Along with the moments, the voxel values are counted in a histogram with 2^16 fixed bins whose key is
+ * the upper 16 bits of an order-preserving integer representation of the value. For 8- and 16-bit integer
+ * volumes each bin holds exactly one value; for floating-point volumes the bins are spaced logarithmically with a
+ * relative width of 2^-7, so that the histogram covers any value range without knowing it in advance. Percentiles
+ * are interpolated within the bins, and uniform histograms over [min, max] are resampled from them.
+ */
+struct VolumeStatistics {
+    enum class KeyType {
+        Exact,    // Key is the value itself
+        Float,    // Key is the upper bits of the order-preserving bit pattern of a float
+        Shifted,  // Key is the upper bits of a 32-bit unsigned integer
+    };
+
+    static constexpr int kNumKeys = 1 << 16;
+
+    uint64_t count = 0;
+    double minVal = 0.0;
+    double maxVal = 0.0;
+    double mean = 0.0;
+    double variance = 0.0;
+    KeyType keyType = KeyType::Exact;
+    std::vector<uint64_t> keyCounts;
+
+    template <typename T>
+    static VolumeStatistics compute(const T *data, uint64_t count) {
+        // Moments of a part of the voxels, merged with Chan et al.'s parallel update
+        struct Moments {
+            uint64_t n = 0;
+            double mean = 0.0;
+            double m2 = 0.0;
+
+            void merge(uint64_t nb, double meanb, double m2b) {
+                const uint64_t total = n + nb;
+                if (total == 0) {
+                    return;
+                }
+                const double delta = meanb - mean;
+                mean += delta * (double)nb / (double)total;
+                m2 += m2b + delta * delta * (double)n * (double)nb / (double)total;
+                n = total;
+            }
+        };
+
+        // Sums of each block are taken around its first value, which keeps them small enough to stay accurate
+        constexpr uint64_t kBlockSize = 1024;
+
+        const int nThreads = omp_get_max_threads();
+        std::vector<uint64_t> localCounts((uint64_t)nThreads * kNumKeys, 0);
+        std::vector<Moments> moments(numParallelChunks(count));
+        std::vector<T> localMins(moments.size()), localMaxs(moments.size());
+
+        parallelForChunks(count, [&](int64_t c, uint64_t begin, uint64_t end) {
+            uint64_t *const hist = localCounts.data() + (uint64_t)omp_get_thread_num() * kNumKeys;
+            Moments m;
+            T minVal = std::numeric_limits<T>::max();
+            T maxVal = std::numeric_limits<T>::lowest();
+            for (uint64_t b = begin; b < end; b += kBlockSize) {
+                const uint64_t bEnd = std::min(end, b + kBlockSize);
+                const double shift = (double)data[b];
+                double sum = 0.0, sq = 0.0;
+                for (uint64_t i = b; i < bEnd; i++) {
+                    const T v = data[i];
+                    minVal = std::min(minVal, v);
+                    maxVal = std::max(maxVal, v);
+                    const double d = (double)v - shift;
+                    sum += d;
+                    sq += d * d;
+                    hist[toKey(v)] += 1;
+                }
+                const double nb = (double)(bEnd - b);
+                m.merge(bEnd - b, shift + sum / nb, std::max(0.0, sq - sum * sum / nb));
+            }
+            moments[c] = m;
+            localMins[c] = minVal;
+            localMaxs[c] = maxVal;
+        });
+
+        VolumeStatistics stats;
+        stats.keyType = keyTypeOf<T>();
+        stats.keyCounts.assign(kNumKeys, 0);
+        OMP_PARALLEL_FOR(int k = 0; k < kNumKeys; k++) {
+            uint64_t sum = 0;
+            for (int t = 0; t < nThreads; t++) {
+                sum += localCounts[(uint64_t)t * kNumKeys + k];
+            }
+            stats.keyCounts[k] = sum;
+        }
+
+        // Chunks are merged in chunk order, so that the result does not depend on the number of threads
+        Moments total;
+        T minVal = std::numeric_limits<T>::max();
+        T maxVal = std::numeric_limits<T>::lowest();
+        for (size_t c = 0; c < moments.size(); c++) {
+            total.merge(moments[c].n, moments[c].mean, moments[c].m2);
+            minVal = std::min(minVal, localMins[c]);
+            maxVal = std::max(maxVal, localMaxs[c]);
+        }
+        stats.count = total.n;
+        stats.mean = total.mean;
+        stats.minVal = (double)minVal;
+        stats.maxVal = (double)maxVal;
+        stats.variance = total.n != 0 ? total.m2 / (double)total.n : 0.0;
+
+        return stats;
+    }
+
+    double stddev() const {
+        return std::sqrt(variance);
+    }
+
+    /**
+     * @brief Value below which the given percentage of voxels falls, e.g., percentile(99.9)
+     */
+    double percentile(double percent) const {
+        LIBCBCT_ASSERT(percent >= 0.0 && percent <= 100.0, "Percentile must be in [0, 100]!");
+        if (count == 0) {
+            return 0.0;
+        }
+
+        const double rank = percent / 100.0 * (double)count;
+        uint64_t cumulative = 0;
+        for (int k = 0; k < kNumKeys; k++) {
+            if (keyCounts[k] == 0) {
+                continue;
+            }
+
+            if ((double)(cumulative + keyCounts[k]) >= rank) {
+                const double t = (rank - (double)cumulative) / (double)keyCounts[k];
+                const auto [lo, hi] = keyRange(k);
+                return std::clamp(lo + t * (hi - lo), minVal, maxVal);
+            }
+            cumulative += keyCounts[k];
+        }
+        return maxVal;
+    }
+
+    /**
+     * @brief Histogram with uniform bins over [min, max]
+     * @details The voxels of each fixed bin are distributed to the uniform bins overlapped by its value range.
+     */
+    std::vector<uint64_t> histogram(int numBins) const {
+        LIBCBCT_ASSERT(numBins > 0, "Number of histogram bins must be positive!");
+
+        std::vector<double> bins(numBins, 0.0);
+        const double width = (maxVal - minVal) / numBins;
+        for (int k = 0; k < kNumKeys; k++) {
+            if (keyCounts[k] == 0) {
+                continue;
+            }
+
+            auto [lo, hi] = keyRange(k);
+            lo = std::clamp(lo, minVal, maxVal);
+            hi = std::clamp(hi, minVal, maxVal);
+            const int b0 = width > 0.0 ? std::min(numBins - 1, (int)((lo - minVal) / width)) : 0;
+            const int b1 = width > 0.0 ? std::min(numBins - 1, (int)((hi - minVal) / width)) : 0;
+            if (b0 == b1 || hi <= lo) {
+                bins[b0] += (double)keyCounts[k];
+                continue;
+            }
+
+            for (int b = b0; b <= b1; b++) {
+                const double overlap = std::min(hi, minVal + (b + 1) * width) - std::max(lo, minVal + b * width);
+                bins[b] += (double)keyCounts[k] * std::max(0.0, overlap) / (hi - lo);
+            }
+        }
+
+        std::vector<uint64_t> ret(numBins);
+        std::transform(bins.begin(), bins.end(), ret.begin(), [](double c) { return (uint64_t)std::llround(c); });
+        return ret;
+    }
+
+private:
+    template <typename T>
+    static constexpr KeyType keyTypeOf() {
+        if constexpr (std::is_floating_point_v<T>) {
+            return KeyType::Float;
+        } else if constexpr (sizeof(T) <= 2) {
+            return KeyType::Exact;
+        } else {
+            return KeyType::Shifted;
+        }
+    }
+
+    template <typename T>
+    static LIBCBCT_FORCEINLINE uint32_t toKey(T v) {
+        if constexpr (std::is_floating_point_v<T>) {
+            const float f = (float)v;
+            uint32_t u;
+            std::memcpy(&u, &f, sizeof(float));
+            u = (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+            return u >> 16;
+        } else if constexpr (sizeof(T) <= 2) {
+            return (uint32_t)v;
+        } else {
+            return (uint32_t)v >> 16;
+        }
+    }
+
+    //! Range of the values counted in the given bin
+    std::pair<double, double> keyRange(int k) const {
+        if (keyType == KeyType::Exact) {
+            return { (double)k, (double)k };
+        } else if (keyType == KeyType::Shifted) {
+            return { (double)((uint32_t)k << 16), (double)(((uint32_t)k << 16) | 0xffffu) };
+        }
+
+        const auto fromOrdered = [](uint32_t u) -> double {
+            u = (u & 0x80000000u) ? (u & 0x7fffffffu) : ~u;
+            float f;
+            std::memcpy(&f, &u, sizeof(float));
+            if (std::isnan(f)) {
+                return (u & 0x80000000u) ? -std::numeric_limits<double>::infinity()
+                                         : std::numeric_limits<double>::infinity();
+            }
+            return (double)f;
+        };
+        return { fromOrdered((uint32_t)k << 16), fromOrdered(((uint32_t)k << 16) | 0xffffu) };
+    }
+};
+
+/**
+ * @brief Error of a volume against a reference volume
+ * @details With fitScale, the volume is first multiplied by the least-squares gain onto the reference, which allows
+ * comparing reconstructions whose overall gain is not calibrated (e.g., against the densities of a phantom). The
+ * PSNR is relative to the value range of the reference. The sums are accumulated in double per chunk and merged in
+ * chunk order, so that the result does not depend on the number of threads.
+ */
+struct VolumeError {
+    double scale = 1.0;
+    double maxAbs = 0.0;
+    double rms = 0.0;
+    double psnr = 0.0;
+
+    static VolumeError compute(const float *volume, const float *reference, uint64_t count, bool fitScale = false) {
+        struct Partial {
+            double vv = 0.0;
+            double vr = 0.0;
+            double minRef = std::numeric_limits<double>::max();
+            double maxRef = std::numeric_limits<double>::lowest();
+        };
+
+        std::vector<Partial> partials(numParallelChunks(count));
+        parallelForChunks(count, [&](int64_t c, uint64_t begin, uint64_t end) {
+            Partial p;
+            for (uint64_t i = begin; i < end; i++) {
+                p.vv += (double)volume[i] * volume[i];
+                p.vr += (double)volume[i] * reference[i];
+                p.minRef = std::min(p.minRef, (double)reference[i]);
+                p.maxRef = std::max(p.maxRef, (double)reference[i]);
+            }
+            partials[c] = p;
+        });
+
+        Partial total;
+        for (const Partial &p : partials) {
+            total.vv += p.vv;
+            total.vr += p.vr;
+            total.minRef = std::min(total.minRef, p.minRef);
+            total.maxRef = std::max(total.maxRef, p.maxRef);
+        }
+
+        VolumeError error;
+        error.scale = fitScale && total.vv > 0.0 ? total.vr / total.vv : 1.0;
+
+        std::vector<std::pair<double, double>> errors(partials.size());
+        parallelForChunks(count, [&](int64_t c, uint64_t begin, uint64_t end) {
+            double sq = 0.0, maxAbs = 0.0;
+            for (uint64_t i = begin; i < end; i++) {
+                const double d = error.scale * volume[i] - reference[i];
+                sq += d * d;
+                maxAbs = std::max(maxAbs, std::abs(d));
+            }
+            errors[c] = { sq, maxAbs };
+        });
+
+        double sq = 0.0;
+        for (const auto &[s, m] : errors) {
+            sq += s;
+            error.maxAbs = std::max(error.maxAbs, m);
+        }
+        error.rms = count != 0 ? std::sqrt(sq / (double)count) : 0.0;
+
+        const double range = count != 0 ? total.maxRef - total.minRef : 0.0;
+        error.psnr = error.rms > 0.0 ? 20.0 * std::log10(range / error.rms) : std::numeric_limits<double>::infinity();
+        return error;
+    }
+};
+
+#endif  // LIBCBCT_VOLUME_STATISTICS_H
@@ -7,19 +7,41 @@
 
 #include "Common/Api.h"
 #include "Common/Constants.h"
+#include "Common/Hash.h"
 #include "Common/Logging.h"
+#include "Common/MemoryTracker.h"
 #include "Common/OpenMP.h"
+#include "Common/Parallel.h"
+#include "Common/PerfCounters.h"
 #include "Common/ProgressBar.h"
+#include "Common/Roofline.h"
+#include "Common/Timing.h"
+#include "Common/Trace.h"
 
 #include "Geometry/GeometryBase.h"
 
+#include "IO/AsyncFileWriter.h"
 #include "IO/BaseImporter.h"
 #include "IO/BaseExporter.h"
+#include "IO/ChunkedVolumeFormat.h"
+#include "IO/ChunkedVolumeExporter.h"
+#include "IO/ChunkedVolumeImporter.h"
+#include "IO/FilteredProjectionCache.h"
 #include "IO/ImageSequenceImporter.h"
+#include "IO/MappedFile.h"
+#include "IO/PyramidVolumeImporter.h"
 #include "IO/RawVolumeExporter.h"
+#include "IO/RawVolumeImporter.h"
+#include "IO/TiffStackExporter.h"
+
+#include "Phantom/Phantom.h"
 
 #include "Reconstruction/ReconstructionBase.h"
+#include "Reconstruction/ReconstructionCheckpoint.h"
+#include "Reconstruction/ReconstructionSession.h"
 #include "Reconstruction/FeldkampCPU.h"
+#include "Reconstruction/MemoryPlanner.h"
+#include "Reconstruction/AutoTuner.h"
 
 #if defined(LIBCBCT_WITH_CUDA)
 #include "Reconstruction/FeldkampCUDA.h"
@@ -30,5 +52,9 @@
 
 #include "Utils/Vec.h"
 #include "Utils/Volume.h"
+#include "Utils/VolumeExpr.h"
+#include "Utils/VolumePyramid.h"
+#include "Utils/VolumeStatistics.h"
+#include "Utils/BrickedVolume.h"
 
 #endif  // LIBCBCT_H
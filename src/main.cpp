@@ -14,28 +14,77 @@
 #include "libcbct.h"
 
 namespace fs = std::filesystem;
+namespace expr = libcbct::expr;
 
-static void onTrackbar(int pos, void *userdata) {
-    const VolumeF32 &tomogram = *(VolumeF32 *)userdata;
-    const int volSize = tomogram.size<0>();
-    const cv::Mat slice(volSize, volSize, CV_32FC1, tomogram.ptr() + (volSize * volSize * pos));
+struct PreviewState {
+    BrickedVolumeF32 volume;
+    std::vector<float> slice;
+    int axis = 2;
+    int index = 0;
+};
+
+static void showSlice(PreviewState &state) {
+    const int sizes[3] = { (int)state.volume.size<0>(), (int)state.volume.size<1>(), (int)state.volume.size<2>() };
+    const int width = sizes[state.axis == 0 ? 1 : 0];
+    const int height = sizes[state.axis == 2 ? 1 : 2];
+    state.slice.resize((size_t)width * height);
+    state.volume.getSlice(state.axis, std::min(state.index, sizes[state.axis] - 1), state.slice.data());
+
+    const cv::Mat slice(height, width, CV_32FC1, state.slice.data());
     cv::imshow("volume", slice);
 }
 
+static void onTrackbar(int pos, void *userdata) {
+    PreviewState &state = *(PreviewState *)userdata;
+    state.index = pos;
+    showSlice(state);
+}
+
+static void onAxisTrackbar(int pos, void *userdata) {
+    PreviewState &state = *(PreviewState *)userdata;
+    state.axis = pos;
+    showSlice(state);
+}
+
 int main(int argc, char **argv) {
     // Parse command line options
     cxxopts::Options options("cbct_ext");
     options.add_options()("h,help", "Print help");
     options.add_options()("c,config", "Input configuration file", cxxopts::value<std::string>());
     options.add_options()("s,size", "Reconstruction volume size (cubic)", cxxopts::value<int>()->default_value("512"));
+    options.add_options()("f,format", "Output volume format (raw, chunked or tiff)",
+                          cxxopts::value<std::string>()->default_value("raw"));
+    options.add_options()("cache", "Reuse the filtered projections cached next to the dataset");
+    options.add_options()("checkpoint", "Save the partial volume every N views (0 to disable)",
+                          cxxopts::value<int>()->default_value("0"));
+    options.add_options()("resume", "Resume from the checkpoint of an interrupted reconstruction");
+    options.add_options()("memory", "Memory budget in GiB (0 for the memory currently available)",
+                          cxxopts::value<float>()->default_value("0"));
+    options.add_options()("dry-run", "Print the memory plan without reconstructing");
+    options.add_options()("p,pyramid", "Number of downsampled levels written with the raw volume",
+                          cxxopts::value<int>()->default_value("0"));
+    options.add_options()("trace", "Write the timings of the pipeline stages to a Chrome trace file",
+                          cxxopts::value<std::string>());
+    options.add_options()("perf", "Print the hardware counters of the filtering, backprojection and export");
+    options.add_options()("memstats", "Print the peak memory of each stage and check it against the memory plan");
+    options.add_options()("roofline", "Print the throughput of the reconstruction against the roofline of the host");
+    options.add_options()("retune", "Tune the reconstruction for this host again, replacing its tuning file");
     const auto configs = options.parse(argc, argv);
 
     if (configs["config"].count() == 0) {
         std::cout << options.help() << std::endl;
         return 0;
     }
+    if (configs["resume"].as<bool>() && configs["checkpoint"].as<int>() <= 0) {
+        LIBCBCT_ERROR("--resume requires --checkpoint N");
+    }
     LIBCBCT_INFO("OpenMP threads: %d", omp_get_max_threads());
     showCudaInfo();
+    Tracer::enable(configs["trace"].count() != 0);
+    if (configs["perf"].count() != 0) {
+        PerfCounters::enable();
+    }
+    MemoryTracker::enable(configs["memstats"].count() != 0);
 
     // Read device parameters
     fs::path configPath(configs["config"].as<std::string>());
@@ -56,58 +105,185 @@ int main(int argc, char **argv) {
     LIBCBCT_DEBUG("SDD: %f mm", sdd);
     LIBCBCT_DEBUG("Pixel size: (%f mm, %f mm)", pixelSizeX, pixelSizeY);
 
+    // Setup projection geometry
+    const int volSize = configs["size"].as<int>();
+    const float voxelSize = pixelSizeY * (sod / sdd) * ((float)detHeight / (float)volSize);
+    LIBCBCT_DEBUG("Reconstruction volume size: %d (%f mm/voxel)", volSize, voxelSize);
+
+    Geometry geometry(vec2i(detWidth, detHeight), vec2f(pixelSizeX, pixelSizeY), vec3i(volSize, volSize, volSize), sod,
+                      sdd);
+
+    // Brick size, view batch and thread counts of this host, which are tuned once and then read from the cache
+#if defined(LIBCBCT_WITH_CUDA)
+    const TuningConfig tuning;
+#else
+    AutoTuner::setAutoTune(true);
+    const TuningConfig tuning = configs["retune"].count() != 0 ? AutoTuner::tune() : AutoTuner::current();
+#endif  // LIBCBCT_WITH_CUDA
+
+    // Plan memory usage
+    MemoryPlanner planner(vec2i(detWidth, detHeight), numberOfProj + 1, vec3i(volSize, volSize, volSize),
+                          tuning.brickSize);
+    planner.setViewBatch(tuning.viewBatch);
+    planner.setBudget((uint64_t)(configs["memory"].as<float>() * 1024.0f * 1024.0f * 1024.0f));
+    planner.setUseCache(configs["cache"].as<bool>());
+    planner.setCheckpoint(configs["checkpoint"].as<int>() > 0);
+    planner.setPyramidLevels(configs["pyramid"].as<int>());
+    planner.setPreview(true);
+    const MemoryPlan plan = planner.plan();
+    if (configs["dry-run"].as<bool>()) {
+        std::cout << plan.report();
+        return 0;
+    }
+    LIBCBCT_DEBUG("%s", plan.report().c_str());
+    if (!plan.fits()) {
+        // The available memory is only a snapshot, so that the run is stopped only for an explicit budget
+        if (configs["memory"].count() != 0) {
+            LIBCBCT_ERROR("Reconstruction does not fit into the memory budget (see the plan above)");
+        }
+        LIBCBCT_WARN("Reconstruction may not fit into the available memory (see the plan above)");
+    }
+
     // Import sinogram
     const fs::path imagePath = configPath.parent_path() / "projections";
     if (!fs::exists(imagePath)) {
         LIBCBCT_ERROR("Projection folder does not exist: %s", imagePath.string().c_str());
     }
 
-    VolumeF32 sinogram = ImageSequenceImporter(imagePath.string(), ".tif", clockwise).read();
-    sinogram.forEach([freeRay](float v) -> float { return -std::log((v + 1.0f) / freeRay); });
-
-    LIBCBCT_ASSERT(
-        sinogram.size<0>() == detWidth && sinogram.size<1>() == detHeight && sinogram.size<2>() - 1 == numberOfProj,
-        "Sinogram size mismatch!");
-    LIBCBCT_DEBUG("Detector size: (%d, %d)", detWidth, detHeight);
-    LIBCBCT_DEBUG("Sinogram: %dx%dx%d", detWidth, detHeight, numberOfProj);
+    const auto checkSinogram = [&](int width, int height, int depth) {
+        LIBCBCT_ASSERT(width == detWidth && height == detHeight && depth - 1 == numberOfProj, "Sinogram size mismatch!");
+        LIBCBCT_DEBUG("Detector size: (%d, %d)", detWidth, detHeight);
+        LIBCBCT_DEBUG("Sinogram: %dx%dx%d", detWidth, detHeight, numberOfProj);
+    };
 
-    // Setup projection geometry
-    const int volSize = configs["size"].as<int>();
-    const float voxelSize = pixelSizeY * (sod / sdd) * ((float)detHeight / (float)volSize);
-    LIBCBCT_DEBUG("Reconstruction volume size: %d (%f mm/voxel)", volSize, voxelSize);
+    const auto importSinogram = [&]() {
+        VolumeF32 sinogram = ImageSequenceImporter(imagePath.string(), ".tif", clockwise).read();
+        {
+            LIBCBCT_TRACE_SCOPE("log transform");
+            sinogram.forEach([freeRay](float v) -> float { return -std::log((v + 1.0f) / freeRay); });
+        }
+        checkSinogram(sinogram.size<0>(), sinogram.size<1>(), sinogram.size<2>());
+        return sinogram;
+    };
 
-    Geometry geometry(vec2i(detWidth, detHeight), vec2f(pixelSizeX, pixelSizeY), vec3i(volSize, volSize, volSize), sod,
-                      sdd);
+    // Raw counts, which are log-transformed per view during the reconstruction
+    const auto importCounts = [&]() {
+        VolumeU16 counts = ImageSequenceImporter(imagePath.string(), ".tif", clockwise).readCounts();
+        checkSinogram(counts.size<0>(), counts.size<1>(), counts.size<2>());
+        return counts;
+    };
+    const bool keepCounts = plan.sinogramType == VolumeType::Uint16;
 
     // Reconstruction
 #if defined(LIBCBCT_WITH_CUDA)
+    if (configs["cache"].as<bool>()) {
+        LIBCBCT_WARN("Filtered projection cache is not supported by the CUDA reconstruction");
+    }
+    if (configs["checkpoint"].as<int>() > 0) {
+        LIBCBCT_WARN("Checkpoints are not supported by the CUDA reconstruction");
+    }
     FeldkampCUDA fdk(RampFilter::SheppLogan);
-    VolumeF32 tomogram = fdk.reconstruct(sinogram, geometry);
+    VolumeF32 tomogram = fdk.reconstruct(importSinogram(), geometry);
 #else
     FeldkampCPU fdk(RampFilter::SheppLogan);
-    VolumeF32 tomogram = fdk.reconstruct(sinogram, geometry);
+    fdk.setSlabHeight(plan.slabHeight);
+    // The host is calibrated here if needed, before the sinogram is imported
+    fdk.setRooflineReport(configs["roofline"].count() != 0);
+    if (plan.checkpoint) {
+        const fs::path checkpointPath = configPath.parent_path() / "reconstruction.ckpt";
+        fdk.setCheckpoint(checkpointPath.string(), configs["checkpoint"].as<int>(), configs["resume"].as<bool>());
+    }
+
+    VolumeF32 tomogram;
+    if (configs["cache"].as<bool>()) {
+        // The filtered projections do not depend on the volume size, so that they are reused across the sizes
+        Hasher key;
+        FilteredProjectionCache::hashFiles(key, imagePath.string(), ".tif");
+        key.add(detWidth, detHeight, pixelSizeX, pixelSizeY, sod, sdd, numberOfProj, clockwise, freeRay,
+                (int)fdk.rampFilter());
+
+        const fs::path cachePath = configPath.parent_path() / "filtered_projections.cache";
+        FilteredProjectionCache cache(cachePath.string());
+        VolumeF32 filtered;
+        if (cache.load(key.value(), filtered)) {
+            LIBCBCT_DEBUG("Load filtered projections from %s", cachePath.string().c_str());
+        } else {
+            filtered = keepCounts ? fdk.filterProjections(importCounts(), freeRay)
+                                  : fdk.filterProjections(importSinogram());
+            cache.store(key.value(), filtered);
+            LIBCBCT_DEBUG("Filtered projections cached: %s", cachePath.string().c_str());
+        }
+        tomogram = fdk.backproject(filtered, geometry);
+    } else {
+        tomogram = keepCounts ? fdk.reconstruct(importCounts(), freeRay, geometry)
+                              : fdk.reconstruct(importSinogram(), geometry);
+    }
 #endif  // LIBCBCT_WITH_CUDA
 
     // Normalize CT values
-    float minVal, maxVal;
-    std::tie(minVal, maxVal) = tomogram.getMinMax();
-    LIBCBCT_DEBUG("min=%f, max=%f", minVal, maxVal);
+    {
+        LIBCBCT_TRACE_SCOPE("normalize");
+        const VolumeStatistics &stats = tomogram.statistics();
+        const float maxVal = (float)stats.maxVal;
+        LIBCBCT_DEBUG("min=%f, max=%f, mean=%f, stddev=%f", stats.minVal, stats.maxVal, stats.mean, stats.stddev());
+        LIBCBCT_DEBUG("0.1%%-99.9%% window: [%f, %f]", stats.percentile(0.1), stats.percentile(99.9));
 
-    tomogram.forEach([minVal, maxVal](float x) { return std::max(0.0f, x) / maxVal; });
+        tomogram = expr::max(0.0f, tomogram) / maxVal;
+    }
 
     // Export tomogram
-    const fs::path outputPath =
-        configPath.parent_path() / "output" / std::format("volume-{0:d}x{0:d}x{0:d}-uint16.raw", volSize);
+    const std::string format = configs["format"].as<std::string>();
+    const std::string extension = format == "chunked" ? ".cbv" : format == "tiff" ? "" : ".raw";
+    const fs::path outputPath = configPath.parent_path() / "output" /
+                                std::format("volume-{0:d}x{0:d}x{0:d}-uint16{1}", volSize, extension);
     fs::create_directories(outputPath.parent_path());
 
-    RawVolumeExporter exporter;
-    exporter.write(outputPath.string(), tomogram, VolumeType::Uint16);
+    if (format == "chunked") {
+        ChunkedVolumeExporter exporter(64, vec3f(voxelSize, voxelSize, voxelSize));
+        exporter.write(outputPath.string(), tomogram, VolumeType::Uint16);
+    } else if (format == "raw") {
+        RawVolumeExporter exporter(false, configs["pyramid"].as<int>());
+        exporter.setBuffering(plan.exportBufferBytes, plan.exportBuffers);
+        exporter.write(outputPath.string(), tomogram, VolumeType::Uint16);
+    } else if (format == "tiff") {
+        TiffStackExporter exporter;
+        exporter.write(outputPath.string(), tomogram, VolumeType::Uint16);
+    } else {
+        LIBCBCT_ERROR("Unknown output format: %s", format.c_str());
+    }
     LIBCBCT_DEBUG("Reconstructed volume saved: %s", outputPath.string().c_str());
 
+    // The volume is kept only in the bricked layout of the preview, which is built before the memory report
+    PreviewState preview;
+    {
+        LIBCBCT_MEMORY_STAGE("preview");
+        preview.volume = BrickedVolumeF32(tomogram, tuning.brickSize);
+        tomogram = VolumeF32();
+    }
+
+    if (Tracer::enabled()) {
+        const std::string tracePath = configs["trace"].as<std::string>();
+        Tracer::writeChromeTrace(tracePath);
+        std::cout << Tracer::summary();
+        LIBCBCT_DEBUG("Trace saved: %s", tracePath.c_str());
+    }
+
+    if (PerfCounters::enabled()) {
+        std::cout << PerfCounters::report();
+    }
+
+    if (MemoryTracker::enabled()) {
+        std::cout << MemoryTracker::report();
+        if (plan.verify(MemoryTracker::stages())) {
+            LIBCBCT_INFO("Peak memory of every stage is within the plan");
+        }
+    }
+
     // Preview
     cv::namedWindow("volume", cv::WINDOW_AUTOSIZE);
-    cv::createTrackbar("#slice", "volume", nullptr, volSize - 1, onTrackbar, &tomogram);
-    onTrackbar(volSize / 2, &tomogram);
+    cv::createTrackbar("#axis", "volume", nullptr, 2, onAxisTrackbar, &preview);
+    cv::createTrackbar("#slice", "volume", nullptr, volSize - 1, onTrackbar, &preview);
+    onTrackbar(volSize / 2, &preview);
 
     cv::waitKey(0);
     cv::destroyAllWindows();